@@ -12,13 +12,25 @@ DEFINES += QT_NO_DEBUG_OUTPUT
 INCLUDEPATH += $$PWD/include
 
 SOURCES += \
+    src/documentsdialog.cpp \
     src/editor.cpp \
+    src/filereader.cpp \
+    src/largefileviewer.cpp \
     src/main.cpp \
-    src/mainwindow.cpp
+    src/mainwindow.cpp \
+    src/memorymanager.cpp \
+    src/profiler.cpp \
+    src/session.cpp
 
 HEADERS += \
+    include/documentsdialog.h \
     include/editor.h \
-    include/mainwindow.h
+    include/filereader.h \
+    include/largefileviewer.h \
+    include/mainwindow.h \
+    include/memorymanager.h \
+    include/profiler.h \
+    include/session.h
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
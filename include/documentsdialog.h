@@ -0,0 +1,66 @@
+/**
+ * @file documentsdialog.h
+ * @brief Dialog listing the open documents and the memory each one holds.
+ * @version 1.0
+ * @date 19/10/2026
+ * @author https://github.com/4g3nt47
+ */
+
+#ifndef DOCUMENTSDIALOG_H
+#define DOCUMENTSDIALOG_H
+
+#include <QDialog>
+#include <QTreeWidget>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+
+/**
+ * @brief The DocumentsDialog class. Shows every open document with its state, estimated memory and idle time, and lets
+ * the user unload documents by hand.
+ */
+class DocumentsDialog : public QDialog{
+
+  Q_OBJECT
+
+  public:
+
+    /**
+     * @brief Creates the dialog.
+     * @param parent The parent widget
+     */
+    DocumentsDialog(QWidget *parent = nullptr);
+
+  private:
+
+    QTreeWidget *documentsTree;
+    QLabel *totalLabel;
+    QPushButton *unloadButton, *enforceButton, *closeButton;
+    QTimer *refreshTimer;
+
+    /**
+     * @brief Format a size for display, e.g: "12.3 MB"
+     * @param bytes The size, in bytes
+     * @return The formatted size
+     */
+    static QString formatSize(qint64 bytes);
+
+  private slots:
+
+    /**
+     * @brief Rebuild the list of documents from the memory manager.
+     */
+    void refresh();
+
+    /**
+     * @brief Unload the selected documents.
+     */
+    void unloadSelected();
+
+    /**
+     * @brief Unload idle documents until the total is within the budget.
+     */
+    void enforceBudget();
+};
+
+#endif // DOCUMENTSDIALOG_H
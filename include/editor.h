@@ -15,6 +15,32 @@
 #include <QFile>
 #include <QFileDialog>
 #include <QIODevice>
+#include <QLabel>
+#include <QTimer>
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QResizeEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QFocusEvent>
+#include <QTextCursor>
+#include <QVector>
+#include <QPointer>
+#include <QList>
+#include <QDateTime>
+#include "largefileviewer.h"
+#include "filereader.h"
+
+/**
+ * @brief Where the user was in a document. Saved with the session, and kept while a document is not loaded.
+ */
+struct ViewState{
+  int anchor = 0; // Cursor anchor position.
+  int position = 0; // Cursor position.
+  int verticalScroll = 0;
+  int horizontalScroll = 0;
+  qint64 topLine = 0; // First visible line, for files open in the large file viewer.
+};
 
 /**
  * @brief The Editor class. Extends the QTextEdit class and implements the editor's application logic.
@@ -25,8 +51,53 @@ class Editor : public QTextEdit{
 
   private:
 
+    /**
+     * @brief A cursor with an optional selection. Kept as plain offsets so thousands of cursors don't each have to be
+     * tracked by the document on every edit.
+     */
+    struct CursorRange{
+      int anchor;
+      int position;
+      int start() const{ return qMin(anchor, position); }
+      int end() const{ return qMax(anchor, position); }
+    };
+
+    /**
+     * @brief The kinds of edit that can be applied at every cursor at once.
+     */
+    enum CursorEdit{
+      InsertText, // Replace the selection with text.
+      DeleteBackward, // Delete the selection, or the character before the cursor.
+      DeleteForward // Delete the selection, or the character after the cursor.
+    };
+
     static QStringList openedFiles; // List of opened files to avoid editing same file in different windows.
+    static qint64 largeFileThreshold; // Files of this size or larger are opened in the read-only viewer.
+    static QList<QPointer<Editor>> preloadQueue; // Editors waiting for a background read of their pending file.
+    static int activePreloads; // Background reads currently running.
     QString currentFile; // The full name of the current file being edited.
+    QLabel *performanceOverlay; // On-screen frame time and input latency display.
+    QTimer *overlayTimer; // Refreshes the performance overlay while it's visible.
+    qint64 lastFrameTime; // Duration of the last paint, in microseconds.
+    qint64 maxFrameTime; // Longest paint since the overlay was last refreshed, in microseconds.
+    qint64 keyPressTime; // Time of the oldest keystroke not yet painted, -1 if none.
+    qint64 lastKeyLatency; // Keystroke-to-paint latency of the last painted keystroke, in microseconds.
+    LargeFileViewer *viewer; // Read-only viewer covering the editor while a large file is open. Created on first use.
+    QVector<CursorRange> extraCursors; // Cursors other than textCursor(), sorted and non-overlapping.
+    bool applyingCursorEdit; // Set while editCursors() is changing the document.
+    bool blockSelecting; // Set while the user is dragging out a rectangular selection.
+    int blockAnchorLine, blockAnchorColumn; // Where the rectangular selection started.
+    bool pending; // Set while currentFile has been assigned but not loaded yet.
+    ViewState pendingState; // View state to apply once the pending file is loaded.
+    FileReader *reader; // Background read of the pending file, if running.
+    QString preloadedText; // Text of the pending file, once read in the background.
+    bool preloaded;
+    qint64 preloadedSize; // Size of the file when preloadedText was read.
+    QDateTime preloadedModified; // Modification time of the file when preloadedText was read.
+    QString autosaveFile; // Where unsaved changes were compacted to when the document was unloaded. Empty if none.
+    qint64 fingerprintSize; // Size of the file when it was unloaded, -1 if it wasn't.
+    QDateTime fingerprintModified; // Modification time of the file when it was unloaded.
+    qint64 lastActivity; // When the user last interacted with the editor, in milliseconds since the epoch.
 
     /**
      * @brief Set the current file being edited. Adds it to the openedFiles list and emits updateWindowTitle()
@@ -34,6 +105,131 @@ class Editor : public QTextEdit{
      */
     void setCurrentFile(const QString &filename);
 
+    /**
+     * @brief Check if frame timings need to be collected, either for the overlay or the profiler.
+     * @return true if paints and keystrokes should be timed
+     */
+    bool isTimingFrames();
+
+    /**
+     * @brief Move the performance overlay to the top-right corner of the viewport.
+     */
+    void placePerformanceOverlay();
+
+    /**
+     * @brief Open a file in the read-only paged viewer.
+     * @param filename The file to open
+     * @return true on success
+     */
+    bool openLargeFile(const QString &filename);
+
+    /**
+     * @brief Close the read-only viewer, if open, and make the editor editable again.
+     */
+    void closeLargeFile();
+
+    /**
+     * @brief Record that the user just interacted with the editor.
+     */
+    void touch();
+
+    /**
+     * @brief Tell the user, in place of the text, that the document is not loaded and how to load it.
+     */
+    void showPendingPlaceholder();
+
+    /**
+     * @brief Start background reads of queued pending files, up to one per core.
+     */
+    static void startQueuedPreloads();
+
+    /**
+     * @brief Cancel the background read of the pending file, if running, discarding what was read.
+     */
+    void stopPreload();
+
+    /**
+     * @brief Wait for the background read of the pending file, if running, and keep its text for ensureLoaded().
+     */
+    void finishPreload();
+
+    /**
+     * @brief Get all cursors, including textCursor(), sorted by position with overlapping cursors merged.
+     * @param mainIndex Set to the index of textCursor() in the returned list
+     * @return The cursors
+     */
+    QVector<CursorRange> allCursors(int *mainIndex);
+
+    /**
+     * @brief Replace all cursors.
+     * @param cursors The new cursors. Need not be sorted.
+     * @param mainIndex Index of the cursor to make textCursor()
+     */
+    void setCursors(QVector<CursorRange> cursors, int mainIndex);
+
+    /**
+     * @brief Apply the same kind of edit at every cursor as a single undo step, with a single relayout and change notification.
+     * @param edit The kind of edit
+     * @param texts The text to insert. Either one string for all cursors, or one per cursor in document order.
+     */
+    void editCursors(CursorEdit edit, const QStringList &texts = QStringList());
+
+    /**
+     * @brief Move every cursor.
+     * @param operation The movement to apply
+     * @param select true to extend each cursor's selection
+     */
+    void moveCursors(QTextCursor::MoveOperation operation, bool select);
+
+    /**
+     * @brief Add a cursor at a position and make it the main cursor.
+     * @param position The position of the new cursor
+     */
+    void addCursor(int position);
+
+    /**
+     * @brief Add a cursor on the line above the topmost cursor or below the bottommost cursor, at the same column.
+     * @param down true to add below, false to add above
+     */
+    void addCursorVertically(bool down);
+
+    /**
+     * @brief Get the line and column under a point in the viewport. Columns past the end of the line are allowed.
+     * @param point The point, in viewport coordinates
+     * @param line Set to the line number
+     * @param column Set to the column
+     */
+    void lineAndColumnAt(const QPoint &point, int *line, int *column);
+
+    /**
+     * @brief Replace all cursors with a rectangular selection, one cursor per line.
+     * @param line The line the mouse is on
+     * @param column The column the mouse is on
+     */
+    void selectBlock(int line, int column);
+
+    /**
+     * @brief Copy the text selected by all cursors to the clipboard, one line per cursor.
+     */
+    void copyCursors();
+
+    /**
+     * @brief Paste the clipboard at every cursor. If it holds one line per cursor, each cursor gets its own line.
+     */
+    void pasteToCursors();
+
+    /**
+     * @brief Handle a key press while multiple cursors are active, or one that adds a cursor.
+     * @param event The key event
+     * @return true if the key was handled
+     */
+    bool handleCursorKey(QKeyEvent *event);
+
+    /**
+     * @brief Draw the carets and selections of the extra cursors in the visible part of the document.
+     */
+    void paintExtraCursors();
+
   public:
 
     /**
@@ -79,6 +275,114 @@ class Editor : public QTextEdit{
      */
     QString getCurrentFile();
 
+    /**
+     * @brief Show/hide the on-screen performance overlay.
+     * @param visible true to show the overlay
+     */
+    void setPerformanceOverlayVisible(bool visible);
+
+    /**
+     * @brief Load a file from disk into the editor, replacing the current document.
+     * @param filename The file to load
+     * @return true on success
+     */
+    bool loadFile(const QString &filename);
+
+    /**
+     * @brief Assign a file to the editor without loading it. It's loaded by ensureLoaded(), which is called when the editor
+     * first gets focus. Used to restore sessions quickly.
+     * @param filename The file to assign
+     * @param state The view state to restore once the file is loaded
+     */
+    void setPendingFile(const QString &filename, const ViewState &state);
+
+    /**
+     * @brief Check if the editor's file has been loaded.
+     * @return false if a pending file is waiting to be loaded
+     */
+    bool isLoaded();
+
+    /**
+     * @brief Load the pending file, if any. Uses the text read in the background by preload() if it's ready.
+     * @return true if the editor's file is loaded
+     */
+    bool ensureLoaded();
+
+    /**
+     * @brief Queue a background read of the pending file, so ensureLoaded() doesn't have to wait on disk.
+     */
+    void preload();
+
+    /**
+     * @brief Drop the document's text, layout and undo history to save memory, keeping only the file name and the view
+     * state. Unsaved changes are compacted to the autosave location. A placeholder is shown until ensureLoaded() reloads
+     * the document, when the editor next gets focus. If the document is not loaded yet, drops the text read in the background
+     * by preload() instead.
+     * @return true if any memory was released
+     */
+    bool unloadDocument();
+
+    /**
+     * @brief Check if the document was unloaded with unsaved changes compacted to the autosave location.
+     * @return true if unsaved changes are held on disk
+     */
+    bool isCompacted();
+
+    /**
+     * @brief Estimate the memory held by the document.
+     * @return The estimate, in bytes
+     */
+    qint64 memoryUsage();
+
+    /**
+     * @brief Get when the user last interacted with the editor.
+     * @return Milliseconds since the epoch
+     */
+    qint64 getLastActivity();
+
+    /**
+     * @brief Get the cursor and scroll positions of the document.
+     * @return The view state
+     */
+    ViewState getViewState();
+
+    /**
+     * @brief Restore the cursor and scroll positions of the document.
+     * @param state The view state
+     */
+    void setViewState(const ViewState &state);
+
+    /**
+     * @brief Check if there's more than one cursor.
+     * @return true if multiple cursors are active
+     */
+    bool hasMultipleCursors();
+
+    /**
+     * @brief Remove all cursors except textCursor().
+     */
+    void clearExtraCursors();
+
+    /**
+     * @brief Check if the current file is open in the read-only large file viewer.
+     * @return true if a large file is open
+     */
+    bool isLargeFileOpen();
+
+    static const qint64 maxLargeFileThreshold = 512 * 1024 * 1024; // Larger files don't fit in a QString once decoded.
+
+    /**
+     * @brief Set the file size at which files are opened in the read-only viewer instead of being loaded. Applies to all editors.
+     * @param bytes The threshold, in bytes. Clamped to maxLargeFileThreshold.
+     */
+    static void setLargeFileThreshold(qint64 bytes);
+
+    /**
+     * @brief Get the file size at which files are opened in the read-only viewer.
+     * @return The threshold, in bytes
+     */
+    static qint64 getLargeFileThreshold();
+
   public slots:
 
     /**
@@ -128,6 +432,77 @@ class Editor : public QTextEdit{
      */
     void about();
 
+  private slots:
+
+    /**
+     * @brief Update the performance overlay with the latest frame timings.
+     */
+    void refreshPerformanceOverlay();
+
+    /**
+     * @brief Called when the document changes. Drops the extra cursors if the change didn't come from editCursors().
+     * @param position Where the change happened
+     * @param removed Number of characters removed
+     * @param added Number of characters added
+     */
+    void documentContentsChange(int position, int removed, int added);
+
+    /**
+     * @brief Called when the background read of the pending file completes.
+     */
+    void preloadFinished();
+
+  protected:
+
+    /**
+     * @brief Paints the editor's viewport. Timed for the profiler and performance overlay.
+     * @param event The paint event
+     */
+    void paintEvent(QPaintEvent *event) override;
+
+    /**
+     * @brief Handles key presses. Records the time of keystrokes that edit the document or move a cursor, used to measure
+     * keystroke-to-paint latency, and applies edits and movement to every cursor while multiple cursors are active.
+     * @param event The key event
+     */
+    void keyPressEvent(QKeyEvent *event) override;
+
+    /**
+     * @brief Handles resizing of the editor, which triggers a relayout of the document.
+     * @param event The resize event
+     */
+    void resizeEvent(QResizeEvent *event) override;
+
+    /**
+     * @brief Handles mouse wheel scrolling. Records it as activity.
+     * @param event The wheel event
+     */
+    void wheelEvent(QWheelEvent *event) override;
+
+    /**
+     * @brief Handles mouse presses. Ctrl+click adds a cursor, Alt+drag starts a rectangular selection.
+     * @param event The mouse event
+     */
+    void mousePressEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Extends a rectangular selection being dragged out.
+     * @param event The mouse event
+     */
+    void mouseMoveEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Ends a rectangular selection being dragged out.
+     * @param event The mouse event
+     */
+    void mouseReleaseEvent(QMouseEvent *event) override;
+
+    /**
+     * @brief Loads the pending file, if any, when the editor first gets focus.
+     * @param event The focus event
+     */
+    void focusInEvent(QFocusEvent *event) override;
+
   signals:
 
     /**
@@ -0,0 +1,75 @@
+/**
+ * @file filereader.h
+ * @brief Reads and decodes a text file on a background thread.
+ * @version 1.0
+ * @date 19/10/2026
+ * @author https://github.com/4g3nt47
+ */
+
+#ifndef FILEREADER_H
+#define FILEREADER_H
+
+#include <QThread>
+#include <QString>
+#include <QDateTime>
+
+/**
+ * @brief The FileReader class. Reads a whole file and decodes it as UTF-8 without blocking the GUI thread. The read is done
+ * in chunks, so it can be stopped quickly with requestInterruption().
+ */
+class FileReader : public QThread{
+
+  Q_OBJECT
+
+  public:
+
+    /**
+     * @brief Creates a reader for the given file. Call start() to begin reading. finished() is emitted when it's done.
+     * @param filename The file to read
+     * @param parent The parent object
+     */
+    FileReader(const QString &filename, QObject *parent = nullptr);
+
+    /**
+     * @brief The class destructor. Stops the read if it's still running.
+     */
+    ~FileReader();
+
+    /**
+     * @brief Check if the file was read successfully. Only valid once the read has finished, e.g: after wait() returns.
+     * @return false if the file could not be read, or the read was interrupted
+     */
+    bool isOk();
+
+    /**
+     * @brief Get the decoded text of the file. Only valid once the read has finished.
+     * @return The text
+     */
+    QString getText();
+
+    /**
+     * @brief Get the size of the file when it was read. Only valid once the read has finished successfully.
+     * @return The size, in bytes
+     */
+    qint64 getSize();
+
+    /**
+     * @brief Get the modification time of the file when it was read. Only valid once the read has finished successfully.
+     * @return The modification time
+     */
+    QDateTime getModified();
+
+  protected:
+
+    void run() override;
+
+  private:
+
+    QString filename;
+    QString text;
+    qint64 size;
+    QDateTime modified;
+    bool ok;
+};
+
+#endif // FILEREADER_H
@@ -0,0 +1,334 @@
+/**
+ * @file largefileviewer.h
+ * @brief Read-only paged viewer for files too large to load into the editor.
+ * @version 1.0
+ * @date 19/10/2026
+ * @author https://github.com/4g3nt47
+ */
+
+#ifndef LARGEFILEVIEWER_H
+#define LARGEFILEVIEWER_H
+
+#include <QAbstractScrollArea>
+#include <QThread>
+#include <QMutex>
+#include <QFile>
+#include <QCache>
+#include <QVector>
+#include <QStringList>
+#include <QByteArray>
+#include <QPaintEvent>
+#include <QKeyEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QResizeEvent>
+
+/**
+ * @brief The LineIndexer class. Scans a file on a background thread and builds a sparse index holding the byte offset of every
+ * linesPerEntry-th line. Safe to query from the GUI thread while it's running.
+ */
+class LineIndexer : public QThread{
+
+  Q_OBJECT
+
+  public:
+
+    /**
+     * @brief Creates an indexer for the given file. Call start() to begin indexing.
+     * @param filename The file to index
+     * @param linesPerEntry Number of lines between consecutive index entries
+     * @param parent The parent object
+     */
+    LineIndexer(const QString &filename, int linesPerEntry, QObject *parent = nullptr);
+
+    /**
+     * @brief The class destructor. Stops the indexing thread if it's still running.
+     */
+    ~LineIndexer();
+
+    /**
+     * @brief Get the number of lines indexed so far.
+     * @return The line count
+     */
+    qint64 lineCount() const;
+
+    /**
+     * @brief Get the number of index entries built so far. Entry N is the offset of line (N * linesPerEntry).
+     * @return The entry count
+     */
+    int entryCount() const;
+
+    /**
+     * @brief Get the byte offset of an index entry.
+     * @param entry The entry number
+     * @return The offset of the first line covered by the entry
+     */
+    qint64 entryOffset(int entry) const;
+
+    /**
+     * @brief Get the end of the indexed region. All lines before this offset have been counted.
+     * @return The offset just past the last indexed line
+     */
+    qint64 indexedBytes() const;
+
+    /**
+     * @brief Check if the whole file has been indexed.
+     * @return true if indexing is complete
+     */
+    bool isComplete() const;
+
+  signals:
+
+    /**
+     * @brief Emitted periodically as indexing proceeds, and once more when it's done.
+     * @param lineCount The number of lines indexed so far
+     */
+    void progress(qint64 lineCount);
+
+  protected:
+
+    void run() override;
+
+  private:
+
+    mutable QMutex mutex;
+    QString filename;
+    int linesPerEntry;
+    QVector<qint64> offsets; // Byte offset of every linesPerEntry-th line.
+    qint64 lines; // Lines counted so far.
+    qint64 scanned; // Offset just past the last counted line.
+    bool complete;
+};
+
+/**
+ * @brief The StreamSearcher class. Searches a file for a string on a background thread without loading it, wrapping
+ * around to the start of the file if needed.
+ */
+class StreamSearcher : public QThread{
+
+  Q_OBJECT
+
+  public:
+
+    /**
+     * @brief Creates a searcher. Call start() to begin searching.
+     * @param filename The file to search
+     * @param needle The UTF-8 encoded string to find
+     * @param from The offset to start searching from
+     * @param parent The parent object
+     */
+    StreamSearcher(const QString &filename, const QByteArray &needle, qint64 from, QObject *parent = nullptr);
+
+    /**
+     * @brief The class destructor. Stops the search if it's still running.
+     */
+    ~StreamSearcher();
+
+  signals:
+
+    /**
+     * @brief Emitted when the search completes.
+     * @param offset The byte offset of the match, -1 if none was found
+     */
+    void searchComplete(qint64 offset);
+
+  protected:
+
+    void run() override;
+
+  private:
+
+    QString filename;
+    QByteArray needle;
+    qint64 from;
+
+    /**
+     * @brief Search a region of the file.
+     * @param file The opened file
+     * @param start The offset to start from
+     * @param end The offset to stop at. A match must start before this offset.
+     * @return The offset of the first match, -1 if none was found
+     */
+    qint64 search(QFile &file, qint64 start, qint64 end);
+};
+
+/**
+ * @brief The LargeFileViewer class. Displays a memory mapped file read-only, decoding only the pages of lines near the viewport.
+ * Decoded pages are kept in a fixed size LRU cache.
+ */
+class LargeFileViewer : public QAbstractScrollArea{
+
+  Q_OBJECT
+
+  public:
+
+    /**
+     * @brief Creates a viewer with no file loaded.
+     * @param parent The parent widget
+     */
+    LargeFileViewer(QWidget *parent = nullptr);
+
+    /**
+     * @brief The class destructor. Stops any background work and unmaps the file.
+     */
+    ~LargeFileViewer();
+
+    /**
+     * @brief Map a file and start indexing it. Closes any file previously opened.
+     * @param filename The file to open
+     * @param errorString Set to a description of the error on failure
+     * @return true on success
+     */
+    bool openFile(const QString &filename, QString *errorString = nullptr);
+
+    /**
+     * @brief Unmap the current file and drop all cached pages.
+     */
+    void closeFile();
+
+    /**
+     * @brief Get the name of the file being viewed.
+     * @return The filename, empty if no file is open
+     */
+    QString getFilename();
+
+    /**
+     * @brief Get the number of the first line in the viewport.
+     * @return The top line, starting from 0
+     */
+    qint64 getTopLine();
+
+    /**
+     * @brief Scroll to a line. If the line has not been indexed yet, the viewer scrolls to it once it is.
+     * @param line The line to scroll to, starting from 0
+     */
+    void setTopLine(qint64 line);
+
+    /**
+     * @brief Get the memory held by the decoded page cache and the line index.
+     * @return The memory used, in bytes
+     */
+    qint64 memoryUsage();
+
+  public slots:
+
+    /**
+     * @brief Find the next occurrence of a string, starting after the last match or the top of the viewport.
+     * @param text The string to find
+     */
+    void find(const QString &text);
+
+  signals:
+
+    /**
+     * @brief Signals the new message that should be displayed in the status bar.
+     * @param msg The message to display
+     * @param delay The message duration, in milliseconds.
+     */
+    void showStatusMessage(const QString &msg, int delay = 2000);
+
+    /**
+     * @brief Signals that the user pressed a key, scrolled or clicked in the viewer. Input goes to the viewer instead of
+     * the Editor underneath it, so the Editor relies on this to track activity.
+     */
+    void userInput();
+
+  private slots:
+
+    /**
+     * @brief Called as the line index grows. Updates the scroll range.
+     * @param lineCount The number of lines indexed so far
+     */
+    void indexProgress(qint64 lineCount);
+
+    /**
+     * @brief Called when a search completes.
+     * @param offset The byte offset of the match, -1 if none was found
+     */
+    void searchFinished(qint64 offset);
+
+  protected:
+
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+    void keyPressEvent(QKeyEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void scrollContentsBy(int dx, int dy) override;
+
+  private:
+
+    static const int linesPerPage = 512; // Lines per decoded page, and per line index entry.
+    static const int maxLineBytes = 16384; // Longer lines are truncated when displayed.
+    static const int pageCacheBytes = 64 * 1024 * 1024; // Upper bound on the memory used by decoded pages.
+
+    /**
+     * @brief A decoded page of lines.
+     */
+    struct Page{
+      QStringList lines;
+    };
+
+    QFile file;
+    const char *data; // The mapped file.
+    qint64 size;
+    LineIndexer *indexer;
+    StreamSearcher *searcher;
+    QCache<qint64, Page> pages; // Decoded pages, keyed by page number. Cost is in bytes.
+    qint64 lineCount; // Lines available for display.
+    qint64 scrollScale; // Lines per scroll bar step. Only above 1 for files with more lines than a scroll bar can hold.
+    qint64 topLine;
+    qint64 pendingTopLine; // Line to scroll to once indexed, -1 if none.
+    int longestLine; // Longest line decoded so far, in characters.
+    QString searchText;
+    qint64 searchFrom; // Offset the next search starts from, -1 to start from the top of the viewport.
+    qint64 pendingMatch; // Offset of a match that has not been indexed yet, -1 if none.
+    qint64 matchLine; // Line holding the last match, -1 if none.
+    qint64 partialPage; // Page decoded before it was fully indexed, -1 if none. Dropped from the cache as the index grows.
+    bool scrollRangeChanged; // Set when decoding finds a longer line than any seen before.
+
+    /**
+     * @brief Get a page of lines, decoding it if it's not cached.
+     * @param pageNumber The page number
+     * @return The page, or nullptr if it has not been indexed yet
+     */
+    const Page *page(qint64 pageNumber);
+
+    /**
+     * @brief Get the line number holding a byte offset.
+     * @param offset The byte offset
+     * @return The line number, -1 if the offset has not been indexed yet
+     */
+    qint64 lineForOffset(qint64 offset);
+
+    /**
+     * @brief Get the byte offset of the start of a line.
+     * @param line The line number
+     * @return The offset of the line, or of the end of the indexed region if the line has not been indexed yet
+     */
+    qint64 offsetForLine(qint64 line);
+
+    /**
+     * @brief Get the number of lines that fit in the viewport.
+     * @return The number of whole lines visible
+     */
+    int visibleLines();
+
+    /**
+     * @brief Update the scroll bar ranges from the current line count and longest line.
+     */
+    void updateScrollBars();
+
+    /**
+     * @brief Stop and delete the running search, if any.
+     */
+    void stopSearch();
+
+    /**
+     * @brief Scroll to and highlight a matched line.
+     * @param line The line holding the match
+     */
+    void showMatch(qint64 line);
+};
+
+#endif // LARGEFILEVIEWER_H
@@ -26,7 +26,12 @@
 #include <QThread>
 #include <QLabel>
 #include <QLineEdit>
+#include <QInputDialog>
+#include <QSignalBlocker>
 #include "editor.h"
+#include "session.h"
+#include "memorymanager.h"
+#include "documentsdialog.h"
 
 /**
  * @brief The MainWindow class.
@@ -40,11 +45,31 @@ class MainWindow : public QMainWindow{
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    /**
+     * @brief Get the state of the window to save with the session.
+     * @return The window state
+     */
+    WindowState getSessionState();
+
+    /**
+     * @brief Restore the window from a saved session.
+     * @param state The saved window state
+     * @param loadNow true to load the file right away, false to read it in the background and load it when focused
+     */
+    void restoreSessionState(const WindowState &state, bool loadNow);
+
+    /**
+     * @brief Load the settings shared by all windows, e.g: the large file threshold and the memory budget. Called once on startup; windows only
+     * load their own settings, so opening one doesn't undo a change made in another.
+     */
+    static void loadSharedSettings();
+
   private:
 
-    QAction *newAction, *openAction, *saveAction, *saveAsAction, *findAction, *exitAction;
-    QAction *lineWrapAction;
+    QAction *newAction, *openAction, *saveAction, *saveAsAction, *findAction, *documentsAction, *exitAction, *quitAction;
+    QAction *lineWrapAction, *largeFileThresholdAction, *memoryBudgetAction, *restoreSessionAction;
     QAction *themeActions[3];
+    QAction *overlayAction, *recordTraceAction, *exportTraceAction;
     QAction *aboutAction, *aboutQtAction;
     QWidget *findAndReplaceWidget;
     QLineEdit *findLineEdit, *replaceLineEdit;
@@ -86,6 +111,11 @@ class MainWindow : public QMainWindow{
      */
     bool setThemeByName(const QString &themeName);
 
+    /**
+     * @brief Close all windows, keeping them all in the saved session so they're restored on the next start.
+     */
+    void quit();
+
   public slots:
 
     /**
@@ -117,6 +147,39 @@ class MainWindow : public QMainWindow{
      */
     void findAndReplace();
 
+    /**
+     * @brief Prompt the user for the file size at which files are opened in the read-only large file viewer.
+     */
+    void changeLargeFileThreshold();
+
+    /**
+     * @brief Prompt the user for the memory budget shared by the documents of all windows.
+     */
+    void changeMemoryBudget();
+
+    /**
+     * @brief Show the list of open documents and the memory each one holds.
+     */
+    void showDocuments();
+
+    /**
+     * @brief Show/hide the performance overlay in the editor.
+     * @param checked true to show the overlay.
+     */
+    void togglePerformanceOverlay(bool checked);
+
+    /**
+     * @brief Start/stop recording of performance trace events.
+     * @param checked true to start recording.
+     */
+    void toggleTraceRecording(bool checked);
+
+    /**
+     * @brief Export the recorded performance trace to a Chrome trace JSON file chosen by the user.
+     * @return true on success
+     */
+    bool exportTrace();
+
   protected:
 
     /**
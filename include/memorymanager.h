@@ -0,0 +1,97 @@
+/**
+ * @file memorymanager.h
+ * @brief Keeps the documents of all open windows within a process-wide memory budget.
+ * @version 1.0
+ * @date 19/10/2026
+ * @author https://github.com/4g3nt47
+ */
+
+#ifndef MEMORYMANAGER_H
+#define MEMORYMANAGER_H
+
+#include <QObject>
+#include <QList>
+#include <QTimer>
+
+class Editor;
+
+/**
+ * @brief The MemoryManager class. Tracks every Editor and, when their combined memory goes over the budget, unloads
+ * the least recently used idle documents until it's back under. Unloaded documents reload when focused.
+ */
+class MemoryManager : public QObject{
+
+  Q_OBJECT
+
+  public:
+
+    /**
+     * @brief Get the process-wide instance, creating it on first use.
+     * @return The memory manager
+     */
+    static MemoryManager *instance();
+
+    /**
+     * @brief Start tracking an editor. Called by the Editor constructor.
+     * @param editor The editor
+     */
+    void registerEditor(Editor *editor);
+
+    /**
+     * @brief Stop tracking an editor. Called by the Editor destructor.
+     * @param editor The editor
+     */
+    void unregisterEditor(Editor *editor);
+
+    /**
+     * @brief Get all tracked editors.
+     * @return The editors
+     */
+    QList<Editor *> getEditors();
+
+    /**
+     * @brief Get the estimated memory held by all documents.
+     * @return The total, in bytes
+     */
+    qint64 totalUsage();
+
+    /**
+     * @brief Set the memory budget for all documents.
+     * @param bytes The budget, in bytes
+     */
+    void setBudget(qint64 bytes);
+
+    /**
+     * @brief Get the memory budget for all documents.
+     * @return The budget, in bytes
+     */
+    qint64 getBudget();
+
+    /**
+     * @brief Get the resident memory of the whole process.
+     * @return The resident set size in bytes, -1 if it's not available on this platform
+     */
+    static qint64 residentMemory();
+
+  public slots:
+
+    /**
+     * @brief Unload idle documents, least recently used first, until the total is within the budget. Documents in the
+     * active window, and documents used within the last few minutes, are never unloaded.
+     * @return The number of documents unloaded
+     */
+    int enforceBudget();
+
+  private:
+
+    static const int checkInterval = 30 * 1000; // How often the budget is enforced, in milliseconds.
+    static const qint64 minimumIdleTime = 5 * 60 * 1000; // Documents used more recently than this are kept, in milliseconds.
+
+    QList<Editor *> editors;
+    QTimer *timer;
+    qint64 budget;
+
+    MemoryManager(QObject *parent = nullptr);
+};
+
+#endif // MEMORYMANAGER_H
@@ -0,0 +1,148 @@
+/**
+ * @file profiler.h
+ * @brief Lightweight scoped timers and counters used to instrument the editor's hot paths.
+ * @version 1.0
+ * @date 19/10/2026
+ * @author https://github.com/4g3nt47
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <atomic>
+
+/**
+ * @brief The Profiler class. A process-wide recorder of timed events and named counters.
+ * Recording is off by default; when disabled, every probe costs a single relaxed atomic load.
+ */
+class Profiler{
+
+  public:
+
+    /**
+     * @brief A single completed timed event.
+     */
+    struct Event{
+      const char *name; // Static string naming the event, e.g: "Editor::openFile"
+      qint64 start; // Start time in microseconds since the profiler's epoch.
+      qint64 duration; // Duration in microseconds.
+      quintptr thread; // ID of the thread the event was recorded on.
+    };
+
+    /**
+     * @brief Check if recording is enabled.
+     * @return true if probes should record
+     */
+    static bool isEnabled(){
+      return enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Enable/disable recording. Events recorded so far are kept.
+     * @param on true to start recording
+     */
+    static void setEnabled(bool on);
+
+    /**
+     * @brief Get the current time.
+     * @return Microseconds elapsed since the profiler's epoch
+     */
+    static qint64 now();
+
+    /**
+     * @brief Record a completed event. Oldest events are dropped once the buffer is full.
+     * @param name Static string naming the event
+     * @param start Start time, as returned by now()
+     * @param duration Duration in microseconds
+     */
+    static void record(const char *name, qint64 start, qint64 duration);
+
+    /**
+     * @brief Add to a named counter. Does nothing if recording is disabled.
+     * @param name Static string naming the counter
+     * @param delta The value to add
+     */
+    static void count(const char *name, qint64 delta = 1);
+
+    /**
+     * @brief Get the current value of a named counter.
+     * @param name The counter name
+     * @return The counter's value, 0 if it was never incremented
+     */
+    static qint64 counter(const char *name);
+
+    /**
+     * @brief Discard all recorded events and counters.
+     */
+    static void clear();
+
+    /**
+     * @brief Get the number of events currently held in the buffer.
+     * @return The event count
+     */
+    static int eventCount();
+
+    /**
+     * @brief Write all recorded events and counters to a file in the Chrome trace event format (chrome://tracing, Perfetto).
+     * @param filename The file to write to
+     * @param errorString Set to a description of the error on failure
+     * @return true on success
+     */
+    static bool exportChromeTrace(const QString &filename, QString *errorString = nullptr);
+
+  private:
+
+    static const int maxEvents = 200000; // Caps the buffer at a few MB.
+
+    static std::atomic<bool> enabled;
+    static QMutex mutex;
+    static QVector<Event> events; // Ring buffer of recorded events.
+    static int nextEvent; // Next slot to overwrite once the ring buffer is full.
+    static QHash<QByteArray, qint64> counters;
+
+    static QElapsedTimer &clock();
+};
+
+/**
+ * @brief Times the enclosing scope and records it with the Profiler. Use the PROFILE_SCOPE() macro.
+ */
+class ScopedTimer{
+
+  public:
+
+    explicit ScopedTimer(const char *name) : name(Profiler::isEnabled() ? name : nullptr), start(this->name ? Profiler::now() : 0){}
+
+    ~ScopedTimer(){
+      if (name)
+        Profiler::record(name, start, Profiler::now() - start);
+    }
+
+  private:
+
+    const char *name; // nullptr if the profiler was disabled on entry.
+    qint64 start;
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+/**
+ * @brief Time the rest of the current scope under the given static name.
+ */
+#define PROFILE_SCOPE(name) ScopedTimer PROFILE_CONCAT(profileScope_, __LINE__)(name)
+
+/**
+ * @brief Increment a named counter by one.
+ */
+#define PROFILE_COUNT(name) do{ if (Profiler::isEnabled()) Profiler::count(name); }while (0)
+
+#endif // PROFILER_H
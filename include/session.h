@@ -0,0 +1,99 @@
+/**
+ * @file session.h
+ * @brief Saves and restores the open windows between runs of the application.
+ * @version 1.0
+ * @date 19/10/2026
+ * @author https://github.com/4g3nt47
+ */
+
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QDataStream>
+#include <QPointer>
+#include "editor.h"
+
+class MainWindow;
+
+/**
+ * @brief The saved state of a single application window.
+ */
+struct WindowState{
+  QString filename; // The file open in the window.
+  ViewState view; // Cursor and scroll positions.
+  bool findVisible = false; // Whether the find-and-replace widget is shown.
+  QString findText, replaceText;
+  QByteArray geometry; // As returned by QWidget::saveGeometry()
+};
+
+QDataStream &operator<<(QDataStream &out, const WindowState &state);
+QDataStream &operator>>(QDataStream &in, WindowState &state);
+
+/**
+ * @brief The Session class. Persists the open windows to a compact binary file, and restores them lazily on startup so
+ * only the active window's file is loaded before the first paint.
+ */
+class Session{
+
+  public:
+
+    /**
+     * @brief Save the state of all open windows.
+     * @param closing A window that's being closed. Left out of the session, unless it's the last window.
+     * @return true on success
+     */
+    static bool save(MainWindow *closing = nullptr);
+
+    /**
+     * @brief Restore the windows of the last session, if enabled in the settings. The active window is loaded and shown right
+     * away. The others are created one per event loop pass once it has been painted, with their files read in the background.
+     * @return The active window, or nullptr if there was no session to restore
+     */
+    static MainWindow *restore();
+
+    /**
+     * @brief Prevent/allow changes to the saved session. Used while all windows are closed on quit, so they all stay in it.
+     * @param locked true to ignore calls to save()
+     */
+    static void setLocked(bool locked);
+
+    /**
+     * @brief Start tracking a window. Called by the MainWindow constructor. Windows are saved in the order they're registered.
+     * @param window The window
+     */
+    static void registerWindow(MainWindow *window);
+
+    /**
+     * @brief Stop tracking a window. Called by the MainWindow destructor.
+     * @param window The window
+     */
+    static void unregisterWindow(MainWindow *window);
+
+  private:
+
+    static const quint32 magic = 0x45445353; // "EDSS"
+    static const quint16 version = 1;
+
+    static bool locked;
+    static bool restoring; // Set until all windows of the last session have been created. Saving is held off until then.
+    static QList<MainWindow *> windows; // Open windows, in the order they were created.
+
+    /**
+     * @brief Get the full name of the session file.
+     * @return The filename
+     */
+    static QString sessionFile();
+
+    /**
+     * @brief Create the next window left to restore, then schedule the one after it.
+     * @param states States of the windows left to restore
+     * @param activeWindow The window to activate once all are restored
+     * @param before How many of the windows left to restore come before the active window in the session
+     */
+    static void restoreNext(QList<WindowState> states, QPointer<MainWindow> activeWindow, int before);
+};
+
+#endif // SESSION_H
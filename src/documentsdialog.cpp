@@ -0,0 +1,109 @@
+#include "documentsdialog.h"
+#include "memorymanager.h"
+#include "editor.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QDateTime>
+
+DocumentsDialog::DocumentsDialog(QWidget *parent) : QDialog(parent){
+
+  setWindowTitle(tr("Open documents"));
+  setMinimumSize(600, 300);
+
+  documentsTree = new QTreeWidget(this);
+  documentsTree->setColumnCount(4);
+  documentsTree->setHeaderLabels(QStringList() << tr("Document") << tr("State") << tr("Memory") << tr("Idle"));
+  documentsTree->setRootIsDecorated(false);
+  documentsTree->setSelectionMode(QAbstractItemView::ExtendedSelection);
+  documentsTree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+
+  totalLabel = new QLabel(this);
+  unloadButton = new QPushButton(tr("&Unload selected"), this);
+  enforceButton = new QPushButton(tr("Enforce &budget"), this);
+  closeButton = new QPushButton(tr("&Close"), this);
+  connect(unloadButton, &QPushButton::clicked, this, &DocumentsDialog::unloadSelected);
+  connect(enforceButton, &QPushButton::clicked, this, &DocumentsDialog::enforceBudget);
+  connect(closeButton, &QPushButton::clicked, this, &DocumentsDialog::close);
+
+  QHBoxLayout *buttons = new QHBoxLayout();
+  buttons->addWidget(unloadButton);
+  buttons->addWidget(enforceButton);
+  buttons->addStretch(1);
+  buttons->addWidget(closeButton);
+  QVBoxLayout *layout = new QVBoxLayout();
+  layout->addWidget(documentsTree, 1);
+  layout->addWidget(totalLabel);
+  layout->addLayout(buttons);
+  setLayout(layout);
+
+  refreshTimer = new QTimer(this);
+  refreshTimer->setInterval(1000);
+  connect(refreshTimer, &QTimer::timeout, this, &DocumentsDialog::refresh);
+  refreshTimer->start();
+  refresh();
+}
+
+QString DocumentsDialog::formatSize(qint64 bytes){
+
+  if (bytes < 1024)
+    return tr("%1 B").arg(bytes);
+  if (bytes < 1024 * 1024)
+    return tr("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+  return tr("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+void DocumentsDialog::refresh(){
+
+  // Remember the selection across the rebuild.
+  QList<quintptr> selected;
+  for (QTreeWidgetItem *item : documentsTree->selectedItems())
+    selected.append(item->data(0, Qt::UserRole).value<quintptr>());
+
+  MemoryManager *manager = MemoryManager::instance();
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  documentsTree->clear();
+  for (Editor *editor : manager->getEditors()){
+    QString filename = editor->getCurrentFile();
+    QString state;
+    if (!editor->isLoaded())
+      state = editor->isCompacted() ? tr("Unloaded (unsaved changes in autosave)") : tr("Unloaded");
+    else if (editor->isLargeFileOpen())
+      state = tr("Read-only (large file)");
+    else
+      state = editor->isWindowModified() ? tr("Loaded, modified") : tr("Loaded");
+    qint64 idle = (now - editor->getLastActivity()) / 1000;
+    QTreeWidgetItem *item = new QTreeWidgetItem(documentsTree);
+    item->setText(0, filename.isEmpty() ? tr("Untitled") : filename);
+    item->setText(1, state);
+    item->setText(2, formatSize(editor->memoryUsage()));
+    item->setText(3, tr("%1:%2").arg(idle / 60).arg(idle % 60, 2, 10, QLatin1Char('0')));
+    item->setTextAlignment(2, Qt::AlignRight | Qt::AlignVCenter);
+    item->setData(0, Qt::UserRole, QVariant::fromValue(reinterpret_cast<quintptr>(editor)));
+    item->setSelected(selected.contains(reinterpret_cast<quintptr>(editor)));
+  }
+  QString total = tr("Documents: %1 of %2 budget").arg(formatSize(manager->totalUsage())).arg(formatSize(manager->getBudget()));
+  qint64 resident = MemoryManager::residentMemory();
+  if (resident >= 0)
+    total += tr(", process resident memory: %1").arg(formatSize(resident));
+  totalLabel->setText(total);
+}
+
+void DocumentsDialog::unloadSelected(){
+
+  QList<Editor *> editors = MemoryManager::instance()->getEditors();
+  for (QTreeWidgetItem *item : documentsTree->selectedItems()){
+    quintptr id = item->data(0, Qt::UserRole).value<quintptr>();
+    for (Editor *editor : editors){ // Only touch editors that still exist.
+      if (reinterpret_cast<quintptr>(editor) == id)
+        editor->unloadDocument();
+    }
+  }
+  refresh();
+}
+
+void DocumentsDialog::enforceBudget(){
+
+  MemoryManager::instance()->enforceBudget();
+  refresh();
+}
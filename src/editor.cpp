@@ -1,14 +1,41 @@
 #include "editor.h"
+#include "profiler.h"
+#include "memorymanager.h"
 #include <QDebug>
+#include <QAbstractTextDocumentLayout>
+#include <QApplication>
+#include <QClipboard>
+#include <QPainter>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QDir>
+#include <QDateTime>
+#include <QCryptographicHash>
+#include <algorithm>
 
 QStringList Editor::openedFiles;
+qint64 Editor::largeFileThreshold = 64 * 1024 * 1024;
+const qint64 Editor::maxLargeFileThreshold;
+QList<QPointer<Editor>> Editor::preloadQueue;
+int Editor::activePreloads = 0;
 
-Editor::Editor(QWidget *parent) : QTextEdit(parent){
+Editor::Editor(QWidget *parent) : QTextEdit(parent), performanceOverlay(nullptr), overlayTimer(nullptr), lastFrameTime(0), maxFrameTime(0),
+                                  keyPressTime(-1), lastKeyLatency(0), viewer(nullptr),
+                                  applyingCursorEdit(false), blockSelecting(false), blockAnchorLine(0), blockAnchorColumn(0),
+                                  pending(false), reader(nullptr), preloaded(false), preloadedSize(-1),
+                                  fingerprintSize(-1), lastActivity(QDateTime::currentMSecsSinceEpoch()){
 
+  MemoryManager::instance()->registerEditor(this);
 }
 
 Editor::~Editor(){
 
+  MemoryManager::instance()->unregisterEditor(this);
+  stopPreload();
+  if (!autosaveFile.isEmpty()) // Unsaved changes were discarded by the user.
+    QFile::remove(autosaveFile);
   documentClosed();
   qDebug() << "Editor closed!";
 }
@@ -20,6 +47,20 @@ void Editor::setupEditor(){
   setFont(QFont("monospace", 14));
   setCurrentFile("");
   connect(this, &QTextEdit::textChanged, this, &Editor::textChanged);
+  connect(document(), &QTextDocument::contentsChange, this, &Editor::documentContentsChange);
+  connect(document()->documentLayout(), &QAbstractTextDocumentLayout::update, this, [](){ PROFILE_COUNT("Editor::repaintRequests"); });
+  connect(verticalScrollBar(), &QScrollBar::actionTriggered, this, &Editor::touch); // Only fired by the user.
+  connect(horizontalScrollBar(), &QScrollBar::actionTriggered, this, &Editor::touch);
+
+  performanceOverlay = new QLabel(this);
+  performanceOverlay->setObjectName("performanceOverlay");
+  performanceOverlay->setFont(QFont("monospace", 9));
+  performanceOverlay->setAutoFillBackground(true); // Opaque, so refreshing it doesn't repaint the text under it.
+  performanceOverlay->setMargin(4);
+  performanceOverlay->hide();
+  overlayTimer = new QTimer(this);
+  overlayTimer->setInterval(250);
+  connect(overlayTimer, &QTimer::timeout, this, &Editor::refreshPerformanceOverlay);
 }
 
 void Editor::setCurrentFile(const QString &filename){
@@ -61,8 +102,492 @@ QString Editor::getCurrentFile(){
   return currentFile;
 }
 
+bool Editor::isLargeFileOpen(){
+  return viewer && !viewer->getFilename().isEmpty();
+}
+
+void Editor::setLargeFileThreshold(qint64 bytes){
+  largeFileThreshold = qBound(Q_INT64_C(1), bytes, maxLargeFileThreshold);
+}
+
+qint64 Editor::getLargeFileThreshold(){
+  return largeFileThreshold;
+}
+
+bool Editor::isTimingFrames(){
+  return Profiler::isEnabled() || (performanceOverlay && performanceOverlay->isVisible());
+}
+
+void Editor::setPerformanceOverlayVisible(bool visible){
+
+  if (!performanceOverlay)
+    return;
+  performanceOverlay->setVisible(visible);
+  if (visible){
+    refreshPerformanceOverlay();
+    overlayTimer->start();
+  }else{
+    overlayTimer->stop();
+  }
+}
+
+void Editor::refreshPerformanceOverlay(){
+
+  QString text = tr("Frame: %1 ms (max %2 ms)\nKey to paint: %3 ms").arg(lastFrameTime / 1000.0, 0, 'f', 2)
+                                                                   .arg(maxFrameTime / 1000.0, 0, 'f', 2)
+                                                                   .arg(lastKeyLatency / 1000.0, 0, 'f', 2);
+  if (Profiler::isEnabled())
+    text += tr("\nTrace events: %1").arg(Profiler::eventCount());
+  performanceOverlay->setText(text);
+  performanceOverlay->adjustSize();
+  placePerformanceOverlay();
+  maxFrameTime = 0;
+}
+
+void Editor::placePerformanceOverlay(){
+
+  QRect area = viewport()->geometry();
+  performanceOverlay->move(area.right() - performanceOverlay->width() - 4, area.top() + 4);
+}
+
+void Editor::paintEvent(QPaintEvent *event){
+
+  if (!isTimingFrames()){
+    QTextEdit::paintEvent(event);
+    paintExtraCursors();
+    return;
+  }
+  qint64 start = Profiler::now();
+  QTextEdit::paintEvent(event);
+  paintExtraCursors();
+  qint64 end = Profiler::now();
+  lastFrameTime = end - start;
+  maxFrameTime = qMax(maxFrameTime, lastFrameTime);
+  if (Profiler::isEnabled())
+    Profiler::record("Editor::paint", start, lastFrameTime);
+  if (keyPressTime >= 0){
+    lastKeyLatency = end - keyPressTime;
+    if (Profiler::isEnabled())
+      Profiler::record("Editor::keystrokeToPaint", keyPressTime, lastKeyLatency);
+    keyPressTime = -1;
+  }
+}
+
+void Editor::keyPressEvent(QKeyEvent *event){
+
+  touch();
+  qint64 start = isTimingFrames() ? Profiler::now() : -1;
+  int revision = document()->revision();
+  int anchor = textCursor().anchor(), position = textCursor().position(), cursors = extraCursors.size();
+  {
+    PROFILE_SCOPE("Editor::keyPress");
+    if (isReadOnly() || !handleCursorKey(event))
+      QTextEdit::keyPressEvent(event);
+  }
+  // Only keys that edit the document or move a cursor lead to a paint. Timing the others (modifiers, ignored keys) would
+  // report the gap to the next unrelated paint, e.g: the cursor blink.
+  bool changed = document()->revision() != revision || textCursor().anchor() != anchor || textCursor().position() != position ||
+                 extraCursors.size() != cursors;
+  if (start >= 0 && keyPressTime < 0 && changed)
+    keyPressTime = start;
+}
+
+void Editor::resizeEvent(QResizeEvent *event){
+
+  PROFILE_SCOPE("Editor::resize"); // Includes the relayout when lines are wrapped to the widget width.
+  QTextEdit::resizeEvent(event);
+  if (viewer)
+    viewer->setGeometry(contentsRect());
+  if (performanceOverlay && performanceOverlay->isVisible())
+    placePerformanceOverlay();
+}
+
+void Editor::wheelEvent(QWheelEvent *event){
+
+  touch();
+  QTextEdit::wheelEvent(event);
+}
+
+void Editor::mousePressEvent(QMouseEvent *event){
+
+  touch();
+  if (event->button() == Qt::LeftButton && !isReadOnly()){
+    if (event->modifiers() & Qt::AltModifier){ // Start a rectangular selection.
+      lineAndColumnAt(event->pos(), &blockAnchorLine, &blockAnchorColumn);
+      blockSelecting = true;
+      selectBlock(blockAnchorLine, blockAnchorColumn);
+      return;
+    }
+    if (event->modifiers() & Qt::ControlModifier){
+      addCursor(cursorForPosition(event->pos()).position());
+      return;
+    }
+  }
+  clearExtraCursors();
+  QTextEdit::mousePressEvent(event);
+}
+
+void Editor::mouseMoveEvent(QMouseEvent *event){
+
+  if (blockSelecting){
+    int line, column;
+    lineAndColumnAt(event->pos(), &line, &column);
+    selectBlock(line, column);
+    return;
+  }
+  QTextEdit::mouseMoveEvent(event);
+}
+
+void Editor::mouseReleaseEvent(QMouseEvent *event){
+
+  if (blockSelecting){
+    blockSelecting = false;
+    return;
+  }
+  QTextEdit::mouseReleaseEvent(event);
+}
+
+bool Editor::hasMultipleCursors(){
+  return !extraCursors.isEmpty();
+}
+
+void Editor::clearExtraCursors(){
+
+  if (extraCursors.isEmpty())
+    return;
+  extraCursors.clear();
+  viewport()->update();
+}
+
+void Editor::documentContentsChange(int position, int removed, int added){
+
+  Q_UNUSED(position);
+  Q_UNUSED(removed);
+  Q_UNUSED(added);
+  if (!applyingCursorEdit) // Offsets of the extra cursors are stale now.
+    clearExtraCursors();
+}
+
+QVector<Editor::CursorRange> Editor::allCursors(int *mainIndex){
+
+  QTextCursor main = textCursor();
+  CursorRange mainRange = {main.anchor(), main.position()};
+  QVector<CursorRange> cursors;
+  cursors.reserve(extraCursors.size() + 1);
+  *mainIndex = -1;
+  for (int i = 0; i <= extraCursors.size(); i++){
+    bool insertMain = *mainIndex < 0 && (i == extraCursors.size() || mainRange.start() <= extraCursors[i].start());
+    if (insertMain){
+      *mainIndex = cursors.size();
+      cursors.append(mainRange);
+    }
+    if (i < extraCursors.size())
+      cursors.append(extraCursors[i]);
+  }
+  // Merge cursors that overlap or sit on the same position.
+  int last = 0;
+  for (int i = 1; i < cursors.size(); i++){
+    CursorRange &previous = cursors[last];
+    const CursorRange &current = cursors[i];
+    if (current.start() < previous.end() || current.start() == previous.start()){
+      int end = qMax(previous.end(), current.end());
+      if (previous.anchor <= previous.position)
+        previous.position = end;
+      else
+        previous.anchor = end;
+      if (i == *mainIndex)
+        *mainIndex = last;
+    }else{
+      last++;
+      cursors[last] = current;
+      if (i == *mainIndex)
+        *mainIndex = last;
+    }
+  }
+  cursors.resize(last + 1);
+  return cursors;
+}
+
+void Editor::setCursors(QVector<CursorRange> cursors, int mainIndex){
+
+  if (cursors.isEmpty())
+    return;
+  CursorRange mainRange = cursors[qBound(0, mainIndex, cursors.size() - 1)];
+  std::stable_sort(cursors.begin(), cursors.end(), [](const CursorRange &a, const CursorRange &b){ return a.start() < b.start(); });
+  extraCursors.clear();
+  extraCursors.reserve(cursors.size() - 1);
+  bool mainFound = false;
+  for (int i = 0; i < cursors.size(); i++){
+    if (!mainFound && cursors[i].anchor == mainRange.anchor && cursors[i].position == mainRange.position){
+      mainFound = true;
+      continue;
+    }
+    extraCursors.append(cursors[i]);
+  }
+  QTextCursor main = textCursor();
+  main.setPosition(mainRange.anchor);
+  main.setPosition(mainRange.position, QTextCursor::KeepAnchor);
+  setTextCursor(main);
+  // Merge cursors that now overlap, e.g: selections extended into each other, or cursors that collapsed onto each other.
+  int index;
+  QVector<CursorRange> merged = allCursors(&index);
+  if (merged[index].anchor != mainRange.anchor || merged[index].position != mainRange.position){ // Main cursor absorbed another.
+    main.setPosition(merged[index].anchor);
+    main.setPosition(merged[index].position, QTextCursor::KeepAnchor);
+    setTextCursor(main);
+  }
+  merged.remove(index);
+  extraCursors = merged;
+  viewport()->update();
+}
+
+void Editor::editCursors(CursorEdit edit, const QStringList &texts){
+
+  PROFILE_SCOPE("Editor::editCursors");
+  int mainIndex;
+  QVector<CursorRange> cursors = allCursors(&mainIndex);
+  int count = cursors.size();
+  // Work out the range each cursor replaces before touching the document, so all offsets refer to the same text.
+  QVector<int> from(count), to(count);
+  QTextCursor cursor(document());
+  for (int i = 0; i < count; i++){
+    int start = cursors[i].start(), end = cursors[i].end();
+    if (start == end && edit == DeleteBackward){
+      cursor.setPosition(start);
+      cursor.movePosition(QTextCursor::PreviousCharacter);
+      start = cursor.position();
+    }else if (start == end && edit == DeleteForward){
+      cursor.setPosition(end);
+      cursor.movePosition(QTextCursor::NextCharacter);
+      end = cursor.position();
+    }
+    if (i > 0 && start < to[i - 1]) // Don't delete the same character twice.
+      start = to[i - 1];
+    from[i] = start;
+    to[i] = qMax(start, end);
+  }
+  // Apply from the last cursor to the first, so earlier offsets stay valid. The edit block makes this a single undo step
+  // and defers relayout and change signals until it ends.
+  applyingCursorEdit = true;
+  cursor.beginEditBlock();
+  for (int i = count - 1; i >= 0; i--){
+    QString text = edit == InsertText ? (texts.size() == count ? texts[i] : texts.value(0)) : QString();
+    cursor.setPosition(from[i]);
+    cursor.setPosition(to[i], QTextCursor::KeepAnchor);
+    if (!text.isEmpty())
+      cursor.insertText(text);
+    else if (cursor.hasSelection())
+      cursor.removeSelectedText();
+  }
+  cursor.endEditBlock();
+  applyingCursorEdit = false;
+  // Each cursor ends up after its inserted text, shifted by the edits made before it.
+  int shift = 0;
+  for (int i = 0; i < count; i++){
+    int length = edit == InsertText ? (texts.size() == count ? texts[i] : texts.value(0)).length() : 0;
+    int position = from[i] + shift + length;
+    cursors[i].anchor = position;
+    cursors[i].position = position;
+    shift += length - (to[i] - from[i]);
+  }
+  setCursors(cursors, mainIndex);
+  ensureCursorVisible();
+}
+
+void Editor::moveCursors(QTextCursor::MoveOperation operation, bool select){
+
+  int mainIndex;
+  QVector<CursorRange> cursors = allCursors(&mainIndex);
+  QTextCursor cursor(document());
+  for (int i = 0; i < cursors.size(); i++){
+    CursorRange &range = cursors[i];
+    if (!select && range.anchor != range.position && (operation == QTextCursor::Left || operation == QTextCursor::Right)){
+      int position = operation == QTextCursor::Left ? range.start() : range.end(); // Collapse the selection.
+      range.anchor = position;
+      range.position = position;
+      continue;
+    }
+    cursor.setPosition(range.anchor);
+    cursor.setPosition(range.position, QTextCursor::KeepAnchor);
+    cursor.movePosition(operation, select ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor);
+    range.anchor = cursor.anchor();
+    range.position = cursor.position();
+  }
+  setCursors(cursors, mainIndex);
+  ensureCursorVisible();
+}
+
+void Editor::addCursor(int position){
+
+  int mainIndex;
+  QVector<CursorRange> cursors = allCursors(&mainIndex);
+  CursorRange range = {position, position};
+  cursors.append(range);
+  setCursors(cursors, cursors.size() - 1);
+}
+
+void Editor::addCursorVertically(bool down){
+
+  int mainIndex;
+  QVector<CursorRange> cursors = allCursors(&mainIndex);
+  int position = down ? cursors.last().position : cursors.first().position;
+  QTextBlock block = document()->findBlock(position);
+  int column = position - block.position();
+  QTextBlock target = down ? block.next() : block.previous();
+  if (!target.isValid())
+    return;
+  addCursor(target.position() + qMin(column, target.length() - 1));
+  ensureCursorVisible();
+}
+
+void Editor::lineAndColumnAt(const QPoint &point, int *line, int *column){
+
+  QTextCursor cursor = cursorForPosition(point);
+  *line = cursor.blockNumber();
+  *column = cursor.positionInBlock();
+  if (cursor.atBlockEnd()){ // Past the end of the line. Keep counting columns so the rectangle keeps its width.
+    int charWidth = qMax(1, fontMetrics().horizontalAdvance(QLatin1Char(' ')));
+    int beyond = point.x() - cursorRect(cursor).x();
+    if (beyond > 0)
+      *column += (beyond + charWidth / 2) / charWidth;
+  }
+}
+
+void Editor::selectBlock(int line, int column){
+
+  PROFILE_SCOPE("Editor::selectBlock");
+  int first = qMin(line, blockAnchorLine), last = qMax(line, blockAnchorLine);
+  QVector<CursorRange> cursors;
+  cursors.reserve(last - first + 1);
+  QTextBlock block = document()->findBlockByNumber(first);
+  for (int i = first; i <= last && block.isValid(); i++, block = block.next()){
+    int length = block.length() - 1; // Excludes the paragraph separator.
+    CursorRange range = {block.position() + qMin(blockAnchorColumn, length), block.position() + qMin(column, length)};
+    cursors.append(range);
+  }
+  if (cursors.isEmpty())
+    return;
+  setCursors(cursors, line >= blockAnchorLine ? cursors.size() - 1 : 0); // The main cursor follows the mouse.
+}
+
+void Editor::copyCursors(){
+
+  int mainIndex;
+  QVector<CursorRange> cursors = allCursors(&mainIndex);
+  QStringList lines;
+  QTextCursor cursor(document());
+  for (int i = 0; i < cursors.size(); i++){
+    if (cursors[i].anchor == cursors[i].position)
+      continue;
+    cursor.setPosition(cursors[i].start());
+    cursor.setPosition(cursors[i].end(), QTextCursor::KeepAnchor);
+    lines.append(cursor.selectedText().replace(QChar::ParagraphSeparator, QLatin1Char('\n')));
+  }
+  if (!lines.isEmpty())
+    QApplication::clipboard()->setText(lines.join(QLatin1Char('\n')));
+}
+
+void Editor::pasteToCursors(){
+
+  QString text = QApplication::clipboard()->text();
+  text.replace(QLatin1String("\r\n"), QLatin1String("\n"));
+  QStringList lines = text.split(QLatin1Char('\n'));
+  if (lines.size() > 1 && lines.last().isEmpty())
+    lines.removeLast();
+  int mainIndex;
+  if (lines.size() == allCursors(&mainIndex).size())
+    editCursors(InsertText, lines); // One line per cursor, e.g: a copied column.
+  else
+    editCursors(InsertText, QStringList(text));
+}
+
+bool Editor::handleCursorKey(QKeyEvent *event){
+
+  Qt::KeyboardModifiers modifiers = event->modifiers() & ~Qt::KeypadModifier;
+  if (modifiers == (Qt::ControlModifier | Qt::AltModifier) && (event->key() == Qt::Key_Up || event->key() == Qt::Key_Down)){
+    addCursorVertically(event->key() == Qt::Key_Down);
+    return true;
+  }
+  if (extraCursors.isEmpty())
+    return false;
+  if (event->matches(QKeySequence::Copy)){
+    copyCursors();
+    return true;
+  }
+  if (event->matches(QKeySequence::Cut)){
+    copyCursors();
+    editCursors(InsertText);
+    return true;
+  }
+  if (event->matches(QKeySequence::Paste)){
+    pasteToCursors();
+    return true;
+  }
+  bool select = modifiers == Qt::ShiftModifier;
+  if (modifiers == Qt::NoModifier || select){
+    switch (event->key()){
+      case Qt::Key_Escape: clearExtraCursors(); return true;
+      case Qt::Key_Backspace: editCursors(DeleteBackward); return true;
+      case Qt::Key_Delete: editCursors(DeleteForward); return true;
+      case Qt::Key_Return:
+      case Qt::Key_Enter: editCursors(InsertText, QStringList(QStringLiteral("\n"))); return true;
+      case Qt::Key_Left: moveCursors(QTextCursor::Left, select); return true;
+      case Qt::Key_Right: moveCursors(QTextCursor::Right, select); return true;
+      case Qt::Key_Up: moveCursors(QTextCursor::Up, select); return true;
+      case Qt::Key_Down: moveCursors(QTextCursor::Down, select); return true;
+      case Qt::Key_Home: moveCursors(QTextCursor::StartOfLine, select); return true;
+      case Qt::Key_End: moveCursors(QTextCursor::EndOfLine, select); return true;
+      default: break;
+    }
+    QString text = event->text();
+    if (!text.isEmpty() && (text.at(0).isPrint() || text.at(0) == QLatin1Char('\t'))){
+      editCursors(InsertText, QStringList(text));
+      return true;
+    }
+  }
+  clearExtraCursors(); // Anything else (undo, select all...) applies to the main cursor only.
+  return false;
+}
+
+void Editor::paintExtraCursors(){
+
+  if (extraCursors.isEmpty())
+    return;
+  int first = cursorForPosition(QPoint(0, 0)).position();
+  int last = cursorForPosition(QPoint(viewport()->width(), viewport()->height())).position();
+  // Cursors are sorted and don't overlap, so their ends are sorted too.
+  QVector<CursorRange>::const_iterator it = std::lower_bound(extraCursors.constBegin(), extraCursors.constEnd(), first,
+                                                             [](const CursorRange &range, int position){ return range.end() < position; });
+  QPainter painter(viewport());
+  QColor selection = palette().color(QPalette::Highlight);
+  selection.setAlpha(110);
+  QColor caret = palette().color(QPalette::Text);
+  int right = viewport()->width();
+  QTextCursor cursor(document());
+  for (; it != extraCursors.constEnd() && it->start() <= last; ++it){
+    if (it->anchor != it->position){
+      cursor.setPosition(it->start());
+      QRect a = cursorRect(cursor);
+      cursor.setPosition(it->end());
+      QRect b = cursorRect(cursor);
+      if (a.top() == b.top()){
+        painter.fillRect(QRect(a.left(), a.top(), b.left() - a.left(), a.height()), selection);
+      }else{ // Spans several lines.
+        painter.fillRect(QRect(a.left(), a.top(), right - a.left(), a.height()), selection);
+        painter.fillRect(QRect(0, a.bottom() + 1, right, b.top() - a.bottom() - 1), selection);
+        painter.fillRect(QRect(0, b.top(), b.left(), b.height()), selection);
+      }
+    }
+    cursor.setPosition(it->position);
+    QRect rect = cursorRect(cursor);
+    painter.fillRect(QRect(rect.left(), rect.top(), cursorWidth(), rect.height()), caret);
+  }
+}
+
 void Editor::textChanged(){
-  setDocumentModified(true);
+
+  if (!isWindowModified()) // Only notify on the transition, not on every keystroke.
+    setDocumentModified(true);
 }
 
 bool Editor::openFile(){
@@ -76,24 +601,371 @@ bool Editor::openFile(){
       QMessageBox::warning(this, tr("Editor"), tr("File is already open!"));
       return false;
     }
-    emit showStatusMessage("Opening file...");
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly)){
+    return loadFile(filename);
+  }
+  return false;
+}
+
+bool Editor::loadFile(const QString &filename){
+
+  PROFILE_SCOPE("Editor::openFile");
+  emit showStatusMessage("Opening file...");
+  // Nothing about the current document changes until the new file has been read, so a failure leaves it as it was.
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)){
+    QMessageBox::warning(this, tr("Editor"), tr("Error reading file: %1\nReason: %2").arg(getBaseFilename(filename)).arg(file.errorString()));
+    return false;
+  }
+  bool large = file.size() >= largeFileThreshold;
+  QByteArray bytes;
+  if (large){
+    file.close();
+    if (!openLargeFile(filename))
+      return false;
+  }else{
+    bytes = file.readAll();
+    if (file.error() != QFileDevice::NoError){
       QMessageBox::warning(this, tr("Editor"), tr("Error reading file: %1\nReason: %2").arg(getBaseFilename(filename)).arg(file.errorString()));
       return false;
     }
-    setCurrentFile(filename);
-    QByteArray bytes = file.readAll();
-    setText(QString::fromStdString(bytes.toStdString()));
-    emit showStatusMessage(tr("File opened: %1").arg(getBaseFilename(filename)));
-    setDocumentModified(false);
+  }
+  stopPreload();
+  pending = false;
+  preloaded = false;
+  preloadedText.clear();
+  fingerprintSize = -1;
+  setPlaceholderText(QString());
+  if (!autosaveFile.isEmpty()){ // Compacted changes the user chose to discard.
+    QFile::remove(autosaveFile);
+    autosaveFile.clear();
+  }
+  if (large) // Already shown by openLargeFile().
+    return true;
+  closeLargeFile();
+  setReadOnly(false);
+  setCurrentFile(filename);
+  setText(QString::fromUtf8(bytes));
+  emit showStatusMessage(tr("File opened: %1").arg(getBaseFilename(filename)));
+  setDocumentModified(false);
+  return true;
+}
+
+void Editor::setPendingFile(const QString &filename, const ViewState &state){
+
+  stopPreload();
+  closeLargeFile();
+  setCurrentFile(filename);
+  pending = true;
+  pendingState = state;
+  preloaded = false;
+  preloadedText.clear();
+  clear();
+  setReadOnly(true); // Nothing to edit until the file is loaded.
+  showPendingPlaceholder();
+  setDocumentModified(false);
+}
+
+void Editor::showPendingPlaceholder(){
+
+  QString name = currentFile.isEmpty() ? tr("Untitled") : getBaseFilename(currentFile);
+  setPlaceholderText(tr("%1 is not loaded. Click here to load it.").arg(name));
+}
+
+bool Editor::isLoaded(){
+  return !pending;
+}
+
+bool Editor::ensureLoaded(){
+
+  if (!pending)
     return true;
+  PROFILE_SCOPE("Editor::ensureLoaded");
+  finishPreload(); // Reading it again would take longer than waiting for a read in flight.
+  touch();
+  setPlaceholderText(QString());
+  QString filename = currentFile;
+  bool modified = false;
+  if (preloaded){ // Possibly read hours ago. Don't show an old version as unmodified, or saving would overwrite the new one.
+    QFileInfo info(filename);
+    if (info.size() != preloadedSize || info.lastModified() != preloadedModified){
+      preloaded = false;
+      preloadedText.clear();
+    }
   }
-  return false;
+  if (!autosaveFile.isEmpty()){ // Compacted unsaved changes. The text lives in the autosave file, not in currentFile.
+    QFile file(autosaveFile);
+    if (file.open(QIODevice::ReadOnly)){
+      preloadedText = QString::fromUtf8(file.readAll());
+      preloaded = true;
+      modified = true;
+      file.close();
+      file.remove();
+    }else{
+      QMessageBox::warning(this, tr("Editor"), tr("Error restoring unsaved changes from: %1\nReason: %2").arg(autosaveFile).arg(file.errorString()));
+    }
+    autosaveFile.clear();
+  }else if (fingerprintSize >= 0){ // Unloaded to save memory. The file is read again either way; just say if it changed meanwhile.
+    QFileInfo info(filename);
+    if (info.size() != fingerprintSize || info.lastModified() != fingerprintModified)
+      QMessageBox::information(this, tr("Editor"), tr("%1 was changed on disk while it was unloaded.\nReloading the new version.").arg(getBaseFilename(filename)));
+  }
+  fingerprintSize = -1;
+  bool loaded;
+  if (preloaded){ // Read and decoded in the background already.
+    pending = false;
+    preloaded = false;
+    closeLargeFile();
+    setReadOnly(false);
+    setText(preloadedText);
+    preloadedText.clear();
+    emit showStatusMessage(tr("File opened: %1").arg(filename.isEmpty() ? tr("Untitled") : getBaseFilename(filename)));
+    setDocumentModified(modified);
+    loaded = true;
+  }else{
+    loaded = !filename.isEmpty() && loadFile(filename);
+  }
+  if (!loaded){ // File is gone or unreadable. Fall back to an untitled document.
+    pending = false;
+    setReadOnly(false);
+    setCurrentFile("");
+    return false;
+  }
+  setViewState(pendingState);
+  return true;
+}
+
+bool Editor::unloadDocument(){
+
+  if (pending){ // Not loaded yet, but its text may have been read in the background. Drop that instead.
+    if (!reader && !preloaded)
+      return false;
+    stopPreload();
+    preloaded = false;
+    preloadedText.clear();
+    return true;
+  }
+  if (blockSelecting)
+    return false;
+  bool modified = isWindowModified();
+  if (!modified && currentFile.isEmpty()) // Nothing to unload.
+    return false;
+  PROFILE_SCOPE("Editor::unloadDocument");
+  ViewState state = getViewState();
+  if (modified){ // Compact the unsaved changes to disk instead of dropping them.
+    QString key = currentFile.isEmpty() ? QString("untitled-%1").arg(reinterpret_cast<quintptr>(this)) : currentFile;
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/autosave";
+    QDir().mkpath(dir);
+    QString filename = dir + "/" + QCryptographicHash::hash(key.toUtf8(), QCryptographicHash::Md5).toHex() + ".txt";
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+      return false;
+    file.write(toPlainText().toUtf8());
+    if (!file.commit())
+      return false;
+    autosaveFile = filename;
+  }else{
+    QFileInfo info(currentFile);
+    fingerprintSize = info.size();
+    fingerprintModified = info.lastModified();
+  }
+  stopPreload();
+  closeLargeFile();
+  clearExtraCursors();
+  pending = true;
+  pendingState = state;
+  preloaded = false;
+  preloadedText.clear();
+  clear(); // Drops the text, its layout and the undo history.
+  setReadOnly(true);
+  showPendingPlaceholder();
+  setDocumentModified(modified);
+  PROFILE_COUNT("Editor::documentsUnloaded");
+  return true;
+}
+
+bool Editor::isCompacted(){
+  return !autosaveFile.isEmpty();
+}
+
+qint64 Editor::memoryUsage(){
+
+  if (pending)
+    return preloaded ? preloadedText.size() * static_cast<qint64>(sizeof(QChar)) : 0;
+  if (isLargeFileOpen())
+    return viewer->memoryUsage();
+  // Rough estimate: the text itself, plus the layout and format data kept for every block.
+  QTextDocument *doc = document();
+  return static_cast<qint64>(doc->characterCount()) * static_cast<qint64>(sizeof(QChar)) + static_cast<qint64>(doc->blockCount()) * 256;
+}
+
+qint64 Editor::getLastActivity(){
+  return lastActivity;
+}
+
+void Editor::touch(){
+  lastActivity = QDateTime::currentMSecsSinceEpoch();
+}
+
+void Editor::preload(){
+
+  if (!pending || reader || preloaded || isLargeFileOpen() || !autosaveFile.isEmpty())
+    return;
+  if (QFileInfo(currentFile).size() >= largeFileThreshold) // Mapped on demand by the viewer instead.
+    return;
+  preloadQueue.append(this);
+  startQueuedPreloads();
+}
+
+void Editor::startQueuedPreloads(){
+
+  MemoryManager *manager = MemoryManager::instance();
+  while (activePreloads < qMax(1, QThread::idealThreadCount()) && !preloadQueue.isEmpty()){
+    if (manager->totalUsage() > manager->getBudget()) // Files left in the queue are read when their window is focused.
+      return;
+    QPointer<Editor> editor = preloadQueue.takeFirst();
+    if (!editor || !editor->pending || editor->reader || editor->preloaded)
+      continue;
+    editor->reader = new FileReader(editor->currentFile, editor);
+    connect(editor->reader, &FileReader::finished, editor.data(), &Editor::preloadFinished);
+    editor->reader->start(QThread::LowPriority);
+    activePreloads++;
+  }
+}
+
+void Editor::stopPreload(){
+
+  if (!reader)
+    return;
+  reader->requestInterruption(); // Stops after the chunk being read.
+  reader->deleteLater(); // Its queued finished() signal, if any, is ignored as it no longer matches reader.
+  reader = nullptr;
+  activePreloads--;
+  startQueuedPreloads();
+}
+
+void Editor::finishPreload(){
+
+  if (!reader)
+    return;
+  reader->wait(); // Returns right away if the read is done.
+  if (reader->isOk() && pending){
+    preloadedText = reader->getText();
+    preloadedSize = reader->getSize();
+    preloadedModified = reader->getModified();
+    preloaded = true;
+  }
+  reader->deleteLater(); // As in stopPreload().
+  reader = nullptr;
+  activePreloads--;
+  startQueuedPreloads();
+}
+
+void Editor::preloadFinished(){
+
+  if (sender() != reader) // Queued from a read that has since been stopped, or already taken by ensureLoaded().
+    return;
+  finishPreload();
+}
+
+ViewState Editor::getViewState(){
+
+  if (pending)
+    return pendingState;
+  ViewState state;
+  if (isLargeFileOpen()){
+    state.topLine = viewer->getTopLine();
+    return state;
+  }
+  QTextCursor cursor = textCursor();
+  state.anchor = cursor.anchor();
+  state.position = cursor.position();
+  state.verticalScroll = verticalScrollBar()->value();
+  state.horizontalScroll = horizontalScrollBar()->value();
+  return state;
+}
+
+void Editor::setViewState(const ViewState &state){
+
+  if (isLargeFileOpen()){
+    viewer->setTopLine(state.topLine);
+    return;
+  }
+  int last = qMax(0, document()->characterCount() - 1);
+  QTextCursor cursor = textCursor();
+  cursor.setPosition(qBound(0, state.anchor, last));
+  cursor.setPosition(qBound(0, state.position, last), QTextCursor::KeepAnchor);
+  setTextCursor(cursor);
+  // The document is laid out lazily, so the scroll range may not cover the saved position until the event loop runs.
+  int vertical = state.verticalScroll, horizontal = state.horizontalScroll;
+  QTimer::singleShot(0, this, [this, vertical, horizontal](){
+    if (vertical > verticalScrollBar()->maximum())
+      ensureCursorVisible();
+    else
+      verticalScrollBar()->setValue(vertical);
+    horizontalScrollBar()->setValue(horizontal);
+  });
+}
+
+void Editor::focusInEvent(QFocusEvent *event){
+
+  QTextEdit::focusInEvent(event);
+  touch();
+  if (pending)
+    QTimer::singleShot(0, this, [this](){ ensureLoaded(); }); // Not from inside the focus event, as loading may show a dialog.
+}
+
+bool Editor::openLargeFile(const QString &filename){
+
+  if (!viewer){
+    viewer = new LargeFileViewer(this);
+    viewer->setFont(font());
+    connect(viewer, &LargeFileViewer::showStatusMessage, this, &Editor::showStatusMessage);
+    connect(viewer, &LargeFileViewer::userInput, this, &Editor::touch); // The viewer is the focus proxy, so it gets the input.
+  }
+  bool replacing = isLargeFileOpen();
+  QString error;
+  if (!viewer->openFile(filename, &error)){
+    if (replacing){ // The viewer closed the previous file before failing. Don't leave its name on an empty document.
+      setFocusProxy(nullptr);
+      viewer->hide();
+      setReadOnly(false);
+      setCurrentFile("");
+      setDocumentModified(false);
+    }
+    QMessageBox::warning(this, tr("Editor"), tr("Error reading file: %1\nReason: %2").arg(getBaseFilename(filename)).arg(error));
+    return false;
+  }
+  setCurrentFile(filename);
+  clear(); // Free the previous document; the viewer pages the file in on demand.
+  setReadOnly(true);
+  viewer->setGeometry(contentsRect());
+  viewer->show();
+  viewer->raise();
+  viewer->setFocus();
+  setFocusProxy(viewer);
+  emit showStatusMessage(tr("Large file opened read-only: %1").arg(getBaseFilename(filename)));
+  setDocumentModified(false);
+  return true;
+}
+
+void Editor::closeLargeFile(){
+
+  if (!isLargeFileOpen())
+    return;
+  setFocusProxy(nullptr);
+  viewer->closeFile();
+  viewer->hide();
+  setReadOnly(false);
 }
 
 bool Editor::saveFile(){
 
+  if (!ensureLoaded())
+    return false;
+  if (isLargeFileOpen()){
+    emit showStatusMessage(tr("Large files are opened read-only!"));
+    return false;
+  }
   QString filename = currentFile;
   if (filename.isEmpty())
     filename = QFileDialog::getSaveFileName(this, tr("Save file"), ".", tr("Text files (*.txt)"));
@@ -111,6 +983,12 @@ bool Editor::saveFile(){
 
 bool Editor::saveFileAs(){
 
+  if (!ensureLoaded())
+    return false;
+  if (isLargeFileOpen()){
+    emit showStatusMessage(tr("Large files are opened read-only!"));
+    return false;
+  }
   QString filename = QFileDialog::getSaveFileName(this, tr("Save file as"), ".", tr("Text files (*.txt)"));
   if (!filename.isEmpty()){
     emit showStatusMessage("Saving file...");
@@ -127,6 +1005,7 @@ bool Editor::saveFileAs(){
 
 bool Editor::writeToFile(const QString &filename){
 
+  PROFILE_SCOPE("Editor::writeToFile");
   QFile file(filename);
   if (!file.open(QIODevice::WriteOnly)){
     QMessageBox::warning(this, "Editor", tr("Error writing to file: %1\nReason: %2").arg(getBaseFilename(filename)).arg(file.errorString()));
@@ -139,8 +1018,15 @@ bool Editor::writeToFile(const QString &filename){
 
 void Editor::findAndReplace(const QString &findStr, const QString &replaceStr){
 
-  if (findStr.isEmpty())
+  if (findStr.isEmpty() || !ensureLoaded())
+    return;
+  if (isLargeFileOpen()){ // Read-only. Stream a search through the file instead.
+    viewer->find(findStr);
+    if (!replaceStr.isEmpty())
+      emit showStatusMessage(tr("Large files are read-only, replace skipped!"), 4000);
     return;
+  }
+  PROFILE_SCOPE("Editor::findAndReplace");
   QString str = toPlainText();
   str.replace(findStr, replaceStr);
   setText(str);
@@ -0,0 +1,63 @@
+#include "filereader.h"
+#include "profiler.h"
+#include <QFile>
+#include <QFileInfo>
+#include <limits>
+
+static const qint64 chunkSize = 4 * 1024 * 1024; // Bytes read between checks for interruption.
+
+FileReader::FileReader(const QString &filename, QObject *parent) : QThread(parent), filename(filename), size(-1), ok(false){
+
+}
+
+FileReader::~FileReader(){
+
+  requestInterruption();
+  wait();
+}
+
+bool FileReader::isOk(){
+  return ok;
+}
+
+QString FileReader::getText(){
+  return text;
+}
+
+qint64 FileReader::getSize(){
+  return size;
+}
+
+QDateTime FileReader::getModified(){
+  return modified;
+}
+
+void FileReader::run(){
+
+  PROFILE_SCOPE("FileReader::run");
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly))
+    return;
+  QFileInfo info(file);
+  size = info.size();
+  modified = info.lastModified(); // Taken before reading, so a change made while reading is caught later.
+  if (size > std::numeric_limits<int>::max() / 2) // Too big for a QByteArray, or for a QString once decoded.
+    return;
+  QByteArray bytes(static_cast<int>(size), Qt::Uninitialized);
+  qint64 total = 0;
+  while (total < bytes.size()){
+    if (isInterruptionRequested())
+      return;
+    qint64 count = file.read(bytes.data() + total, qMin(chunkSize, bytes.size() - total));
+    if (count < 0)
+      return;
+    if (count == 0) // File shrank since it was opened.
+      break;
+    total += count;
+  }
+  bytes.truncate(total);
+  if (isInterruptionRequested())
+    return;
+  text = QString::fromUtf8(bytes);
+  ok = true;
+}
@@ -0,0 +1,519 @@
+#include "largefileviewer.h"
+#include "profiler.h"
+#include <QPainter>
+#include <QScrollBar>
+#include <QByteArrayMatcher>
+#include <QTimer>
+#include <cstring>
+#include <limits>
+
+static const qint64 chunkSize = 64 * 1024 * 1024; // Bytes mapped at a time by the background threads.
+
+LineIndexer::LineIndexer(const QString &filename, int linesPerEntry, QObject *parent) : QThread(parent), filename(filename),
+                                                                                      linesPerEntry(linesPerEntry), lines(0), scanned(0),
+                                                                                      complete(false){
+  offsets.append(0); // The first line always starts at the beginning of the file.
+}
+
+LineIndexer::~LineIndexer(){
+
+  requestInterruption();
+  wait();
+}
+
+qint64 LineIndexer::lineCount() const{
+
+  QMutexLocker locker(&mutex);
+  return lines;
+}
+
+int LineIndexer::entryCount() const{
+
+  QMutexLocker locker(&mutex);
+  return offsets.size();
+}
+
+qint64 LineIndexer::entryOffset(int entry) const{
+
+  QMutexLocker locker(&mutex);
+  return offsets[entry];
+}
+
+qint64 LineIndexer::indexedBytes() const{
+
+  QMutexLocker locker(&mutex);
+  return scanned;
+}
+
+bool LineIndexer::isComplete() const{
+
+  QMutexLocker locker(&mutex);
+  return complete;
+}
+
+void LineIndexer::run(){
+
+  PROFILE_SCOPE("LineIndexer::run");
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)){
+    {
+      QMutexLocker locker(&mutex);
+      complete = true;
+    }
+    emit progress(0);
+    return;
+  }
+  qint64 size = file.size();
+  qint64 count = 0;
+  qint64 lineEnd = 0; // Offset just past the last newline found.
+  QVector<qint64> batch; // New entries, published once per chunk to keep lock traffic low.
+  for (qint64 pos = 0; pos < size && !isInterruptionRequested(); pos += chunkSize){
+    qint64 length = qMin(chunkSize, size - pos);
+    QByteArray buffer;
+    uchar *mapped = file.map(pos, length);
+    const char *begin = reinterpret_cast<const char *>(mapped);
+    if (!mapped){ // Mapping failed (e.g. out of address space). Fall back to reading the chunk.
+      file.seek(pos);
+      buffer = file.read(length);
+      begin = buffer.constData();
+      length = buffer.size();
+      if (length == 0)
+        break;
+    }
+    const char *end = begin + length;
+    const char *p = begin;
+    while ((p = static_cast<const char *>(memchr(p, '\n', end - p)))){
+      p++;
+      count++;
+      lineEnd = pos + (p - begin);
+      if (count % linesPerEntry == 0)
+        batch.append(lineEnd);
+    }
+    if (mapped)
+      file.unmap(mapped);
+    {
+      QMutexLocker locker(&mutex);
+      offsets += batch;
+      lines = count;
+      scanned = lineEnd;
+    }
+    batch.clear();
+    emit progress(count);
+  }
+  if (isInterruptionRequested())
+    return;
+  {
+    QMutexLocker locker(&mutex);
+    if (size > lineEnd) // The last line has no trailing newline.
+      count++;
+    lines = count;
+    scanned = size;
+    complete = true;
+  }
+  emit progress(count);
+}
+
+StreamSearcher::StreamSearcher(const QString &filename, const QByteArray &needle, qint64 from, QObject *parent) : QThread(parent),
+                                                                                                                 filename(filename),
+                                                                                                                 needle(needle), from(from){
+
+}
+
+StreamSearcher::~StreamSearcher(){
+
+  requestInterruption();
+  wait();
+}
+
+void StreamSearcher::run(){
+
+  PROFILE_SCOPE("StreamSearcher::run");
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)){
+    emit searchComplete(-1);
+    return;
+  }
+  qint64 start = qBound(Q_INT64_C(0), from, file.size());
+  qint64 offset = search(file, start, file.size());
+  if (offset < 0 && start > 0) // Wrap around to the beginning of the file.
+    offset = search(file, 0, start);
+  emit searchComplete(isInterruptionRequested() ? -1 : offset);
+}
+
+qint64 StreamSearcher::search(QFile &file, qint64 start, qint64 end){
+
+  QByteArrayMatcher matcher(needle);
+  qint64 size = file.size();
+  qint64 overlap = needle.size() - 1; // So matches spanning two chunks are found.
+  for (qint64 pos = start; pos < end && !isInterruptionRequested(); pos += chunkSize){
+    qint64 length = qMin(chunkSize + overlap, size - pos);
+    QByteArray buffer;
+    uchar *mapped = file.map(pos, length);
+    const char *begin = reinterpret_cast<const char *>(mapped);
+    if (!mapped){
+      file.seek(pos);
+      buffer = file.read(length);
+      begin = buffer.constData();
+      length = buffer.size();
+    }
+    int index = matcher.indexIn(begin, static_cast<int>(length), 0);
+    if (mapped)
+      file.unmap(mapped);
+    if (index >= 0){
+      if (pos + index >= end)
+        return -1;
+      if (index < chunkSize)
+        return pos + index;
+      // Match starts in the overlap; the next chunk will report it.
+    }
+  }
+  return -1;
+}
+
+LargeFileViewer::LargeFileViewer(QWidget *parent) : QAbstractScrollArea(parent), data(nullptr), size(0), indexer(nullptr), searcher(nullptr),
+                                                    pages(pageCacheBytes), lineCount(0), scrollScale(1), topLine(0), pendingTopLine(-1),
+                                                    longestLine(0), searchFrom(-1), pendingMatch(-1), matchLine(-1), partialPage(-1),
+                                                    scrollRangeChanged(false){
+  setFrameShape(QFrame::NoFrame);
+  setFocusPolicy(Qt::StrongFocus);
+  verticalScrollBar()->setSingleStep(1);
+  horizontalScrollBar()->setSingleStep(1);
+  connect(verticalScrollBar(), &QScrollBar::actionTriggered, this, &LargeFileViewer::userInput); // Only fired by the user.
+  connect(horizontalScrollBar(), &QScrollBar::actionTriggered, this, &LargeFileViewer::userInput);
+}
+
+LargeFileViewer::~LargeFileViewer(){
+  closeFile();
+}
+
+bool LargeFileViewer::openFile(const QString &filename, QString *errorString){
+
+  PROFILE_SCOPE("LargeFileViewer::openFile");
+  closeFile();
+  file.setFileName(filename);
+  if (!file.open(QIODevice::ReadOnly)){
+    if (errorString)
+      *errorString = file.errorString();
+    return false;
+  }
+  size = file.size();
+  if (size > 0){
+    data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data){
+      if (errorString)
+        *errorString = file.errorString();
+      file.close();
+      size = 0;
+      return false;
+    }
+  }
+  indexer = new LineIndexer(filename, linesPerPage, this);
+  connect(indexer, &LineIndexer::progress, this, &LargeFileViewer::indexProgress);
+  indexer->start(QThread::LowPriority);
+  updateScrollBars();
+  viewport()->update();
+  return true;
+}
+
+void LargeFileViewer::closeFile(){
+
+  stopSearch();
+  delete indexer; // Waits for the thread to stop.
+  indexer = nullptr;
+  pages.clear();
+  if (data)
+    file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+  data = nullptr;
+  file.close();
+  file.setFileName(QString());
+  size = 0;
+  lineCount = 0;
+  topLine = 0;
+  pendingTopLine = -1;
+  longestLine = 0;
+  searchText.clear();
+  searchFrom = -1;
+  pendingMatch = -1;
+  matchLine = -1;
+  partialPage = -1;
+  updateScrollBars();
+  viewport()->update();
+}
+
+QString LargeFileViewer::getFilename(){
+  return file.fileName();
+}
+
+qint64 LargeFileViewer::getTopLine(){
+  return pendingTopLine >= 0 ? pendingTopLine : topLine;
+}
+
+void LargeFileViewer::setTopLine(qint64 line){
+
+  if (line >= lineCount && indexer && !indexer->isComplete()){ // Not indexed yet. Try again as the index grows.
+    pendingTopLine = line;
+    return;
+  }
+  pendingTopLine = -1;
+  line = qBound(Q_INT64_C(0), line, qMax(Q_INT64_C(0), lineCount - visibleLines()));
+  verticalScrollBar()->setValue(static_cast<int>(line / scrollScale));
+  topLine = line; // Set after the scroll bar so we keep full precision when scrollScale > 1.
+  viewport()->update();
+}
+
+qint64 LargeFileViewer::memoryUsage(){
+  return pages.totalCost() + (indexer ? static_cast<qint64>(indexer->entryCount()) * static_cast<qint64>(sizeof(qint64)) : 0);
+}
+
+void LargeFileViewer::find(const QString &text){
+
+  if (text.isEmpty() || !indexer)
+    return;
+  if (text != searchText || searchFrom < 0){ // New search. Start from the top of the viewport.
+    searchText = text;
+    searchFrom = offsetForLine(topLine);
+  }
+  stopSearch();
+  searcher = new StreamSearcher(file.fileName(), text.toUtf8(), searchFrom, this);
+  connect(searcher, &StreamSearcher::searchComplete, this, &LargeFileViewer::searchFinished);
+  searcher->start();
+  emit showStatusMessage(tr("Searching..."), 0);
+}
+
+void LargeFileViewer::indexProgress(qint64 lineCount){
+
+  if (sender() != indexer) // Queued from the indexer of a file that has since been closed.
+    return;
+  this->lineCount = lineCount;
+  if (partialPage >= 0){ // The page may have grown since it was decoded.
+    pages.remove(partialPage);
+    partialPage = -1;
+  }
+  updateScrollBars();
+  if (pendingTopLine >= 0)
+    setTopLine(pendingTopLine);
+  if (pendingMatch >= 0){
+    qint64 line = lineForOffset(pendingMatch);
+    if (line >= 0){
+      pendingMatch = -1;
+      showMatch(line);
+    }
+  }
+  if (indexer->isComplete())
+    emit showStatusMessage(tr("Indexed %1 lines").arg(lineCount));
+  viewport()->update();
+}
+
+void LargeFileViewer::searchFinished(qint64 offset){
+
+  if (sender() != searcher) // Queued from a search that has since been cancelled.
+    return;
+  searcher->deleteLater();
+  searcher = nullptr;
+  if (offset < 0){
+    searchFrom = -1;
+    emit showStatusMessage(tr("Keyword not found!"));
+    return;
+  }
+  searchFrom = offset + 1;
+  qint64 line = lineForOffset(offset);
+  if (line < 0){
+    pendingMatch = offset;
+    emit showStatusMessage(tr("Keyword found, waiting for indexing to reach it..."), 0);
+    return;
+  }
+  showMatch(line);
+}
+
+void LargeFileViewer::showMatch(qint64 line){
+
+  matchLine = line;
+  setTopLine(line - visibleLines() / 2);
+  emit showStatusMessage(tr("Keyword found on line %1").arg(line + 1));
+}
+
+void LargeFileViewer::stopSearch(){
+
+  delete searcher; // Waits for the thread to stop.
+  searcher = nullptr;
+}
+
+const LargeFileViewer::Page *LargeFileViewer::page(qint64 pageNumber){
+
+  Page *cached = pages.object(pageNumber);
+  if (cached)
+    return cached;
+  if (!data || pageNumber >= indexer->entryCount())
+    return nullptr;
+  PROFILE_SCOPE("LargeFileViewer::decodePage");
+  bool partial = pageNumber + 1 >= indexer->entryCount() && !indexer->isComplete();
+  qint64 start = indexer->entryOffset(static_cast<int>(pageNumber));
+  qint64 end = pageNumber + 1 < indexer->entryCount() ? indexer->entryOffset(static_cast<int>(pageNumber + 1)) : indexer->indexedBytes();
+  Page *result = new Page();
+  int cost = sizeof(Page);
+  const char *p = data + start;
+  const char *stop = data + end;
+  while (p < stop && result->lines.size() < linesPerPage){
+    const char *newline = static_cast<const char *>(memchr(p, '\n', stop - p));
+    const char *lineEnd = newline ? newline : stop;
+    qint64 length = lineEnd - p;
+    bool truncated = length > maxLineBytes;
+    QString line = QString::fromUtf8(p, truncated ? static_cast<int>(maxLineBytes) : static_cast<int>(length));
+    if (line.endsWith(QLatin1Char('\r')))
+      line.chop(1);
+    line.replace(QLatin1Char('\t'), QLatin1String("    "));
+    if (truncated)
+      line += QChar(0x2026); // Ellipsis.
+    if (line.size() > longestLine){
+      longestLine = line.size();
+      scrollRangeChanged = true;
+    }
+    cost += line.size() * static_cast<int>(sizeof(QChar)) + static_cast<int>(sizeof(QString));
+    result->lines.append(line);
+    if (!newline)
+      break;
+    p = newline + 1;
+  }
+  if (partial)
+    partialPage = pageNumber;
+  pages.insert(pageNumber, result, cost);
+  PROFILE_COUNT("LargeFileViewer::pagesDecoded");
+  return pages.object(pageNumber); // nullptr in the unlikely case the page was too large to cache.
+}
+
+qint64 LargeFileViewer::lineForOffset(qint64 offset){
+
+  if (!indexer || !data || offset >= size)
+    return -1;
+  if (offset >= indexer->indexedBytes() && !indexer->isComplete())
+    return -1;
+  // Find the last index entry at or before the offset, then count the newlines between them.
+  int low = 0, high = indexer->entryCount() - 1;
+  while (low < high){
+    int mid = (low + high + 1) / 2;
+    if (indexer->entryOffset(mid) <= offset)
+      low = mid;
+    else
+      high = mid - 1;
+  }
+  qint64 line = static_cast<qint64>(low) * linesPerPage;
+  const char *p = data + indexer->entryOffset(low);
+  const char *stop = data + offset;
+  while (p < stop && (p = static_cast<const char *>(memchr(p, '\n', stop - p)))){
+    p++;
+    line++;
+  }
+  return line;
+}
+
+qint64 LargeFileViewer::offsetForLine(qint64 line){
+
+  if (!indexer || !data)
+    return 0;
+  qint64 entry = line / linesPerPage;
+  if (entry >= indexer->entryCount())
+    return indexer->indexedBytes();
+  const char *p = data + indexer->entryOffset(static_cast<int>(entry));
+  const char *stop = data + size;
+  for (qint64 i = entry * linesPerPage; i < line && p < stop; i++){
+    const char *newline = static_cast<const char *>(memchr(p, '\n', stop - p));
+    if (!newline)
+      break;
+    p = newline + 1;
+  }
+  return p - data;
+}
+
+int LargeFileViewer::visibleLines(){
+  return qMax(1, viewport()->height() / fontMetrics().lineSpacing());
+}
+
+void LargeFileViewer::updateScrollBars(){
+
+  scrollRangeChanged = false;
+  qint64 maxTop = qMax(Q_INT64_C(0), lineCount - visibleLines());
+  scrollScale = maxTop / std::numeric_limits<int>::max() + 1;
+  verticalScrollBar()->setRange(0, static_cast<int>(maxTop / scrollScale));
+  verticalScrollBar()->setPageStep(qMax(1, static_cast<int>(visibleLines() / scrollScale)));
+  int columns = qMax(1, viewport()->width() / fontMetrics().horizontalAdvance(QLatin1Char('M')));
+  horizontalScrollBar()->setRange(0, qMax(0, longestLine - columns + 1));
+  horizontalScrollBar()->setPageStep(columns);
+}
+
+void LargeFileViewer::paintEvent(QPaintEvent *event){
+
+  Q_UNUSED(event);
+  PROFILE_SCOPE("LargeFileViewer::paint");
+  QPainter painter(viewport());
+  QFontMetrics metrics = fontMetrics();
+  int lineHeight = metrics.lineSpacing();
+  int column = horizontalScrollBar()->value();
+  int columns = viewport()->width() / metrics.horizontalAdvance(QLatin1Char('M')) + 2;
+  int rows = viewport()->height() / lineHeight + 1;
+  for (int i = 0; i < rows && topLine + i < lineCount; i++){
+    qint64 line = topLine + i;
+    const Page *current = page(line / linesPerPage);
+    if (!current)
+      break;
+    int index = static_cast<int>(line % linesPerPage);
+    if (index >= current->lines.size())
+      continue;
+    QRect rect(0, i * lineHeight, viewport()->width(), lineHeight);
+    if (line == matchLine){
+      painter.fillRect(rect, palette().highlight());
+      painter.setPen(palette().color(QPalette::HighlightedText));
+    }else{
+      painter.setPen(palette().color(QPalette::Text));
+    }
+    // Only draw the visible columns; lines can be thousands of characters long.
+    painter.drawText(4, i * lineHeight + metrics.ascent(), current->lines[index].mid(column, columns));
+  }
+  if (scrollRangeChanged) // Can't safely change scroll ranges while painting.
+    QTimer::singleShot(0, this, [this](){ updateScrollBars(); });
+}
+
+void LargeFileViewer::resizeEvent(QResizeEvent *event){
+
+  QAbstractScrollArea::resizeEvent(event);
+  updateScrollBars();
+}
+
+void LargeFileViewer::keyPressEvent(QKeyEvent *event){
+
+  PROFILE_SCOPE("LargeFileViewer::keyPress");
+  emit userInput();
+  QScrollBar *vertical = verticalScrollBar();
+  QScrollBar *horizontal = horizontalScrollBar();
+  bool ctrl = event->modifiers() & Qt::ControlModifier;
+  switch (event->key()){
+    case Qt::Key_Up: vertical->triggerAction(QAbstractSlider::SliderSingleStepSub); break;
+    case Qt::Key_Down: vertical->triggerAction(QAbstractSlider::SliderSingleStepAdd); break;
+    case Qt::Key_PageUp: vertical->triggerAction(QAbstractSlider::SliderPageStepSub); break;
+    case Qt::Key_PageDown: vertical->triggerAction(QAbstractSlider::SliderPageStepAdd); break;
+    case Qt::Key_Left: horizontal->triggerAction(QAbstractSlider::SliderSingleStepSub); break;
+    case Qt::Key_Right: horizontal->triggerAction(QAbstractSlider::SliderSingleStepAdd); break;
+    case Qt::Key_Home: (ctrl ? vertical : horizontal)->triggerAction(QAbstractSlider::SliderToMinimum); break;
+    case Qt::Key_End: (ctrl ? vertical : horizontal)->triggerAction(QAbstractSlider::SliderToMaximum); break;
+    default: QAbstractScrollArea::keyPressEvent(event);
+  }
+}
+
+void LargeFileViewer::wheelEvent(QWheelEvent *event){
+
+  emit userInput();
+  QAbstractScrollArea::wheelEvent(event);
+}
+
+void LargeFileViewer::mousePressEvent(QMouseEvent *event){
+
+  emit userInput();
+  QAbstractScrollArea::mousePressEvent(event);
+}
+
+void LargeFileViewer::scrollContentsBy(int dx, int dy){
+
+  Q_UNUSED(dx);
+  Q_UNUSED(dy);
+  topLine = static_cast<qint64>(verticalScrollBar()->value()) * scrollScale;
+  viewport()->update();
+}
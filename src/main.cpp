@@ -1,9 +1,16 @@
 #include "mainwindow.h"
 #include "editor.h"
+#include "profiler.h"
+#include "session.h"
 
 int main(int argc, char *argv[]){
 
   QApplication app(argc, argv);
+  app.setOrganizationName("Umar Abdul");
+  app.setApplicationName("Editor");
+  if (qEnvironmentVariableIsSet("EDITOR_PROFILE")) // Record from startup, for profiling the launch itself.
+    Profiler::setEnabled(true);
+  MainWindow::loadSharedSettings();
   app.setFont(QFont("helvetica", 11));
   app.setStyle("breeze"); // Goes well with our custom themes.
 
@@ -22,8 +29,11 @@ int main(int argc, char *argv[]){
   splash->showMessage("Starting the editor...", align, Qt::white);
   QThread::msleep(500);
 
-  MainWindow *mainWindow = new MainWindow();
-  mainWindow->show();
+  MainWindow *mainWindow = Session::restore();
+  if (!mainWindow){ // Nothing to restore. Start with an empty document.
+    mainWindow = new MainWindow();
+    mainWindow->show();
+  }
   QApplication::restoreOverrideCursor(); // Revert back to normal cursor since we finished loading.
 
   splash->finish(mainWindow);
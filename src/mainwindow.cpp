@@ -1,8 +1,10 @@
 #include "mainwindow.h"
+#include "profiler.h"
 #include <QDebug>
 
 MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent){
 
+  Session::registerWindow(this);
   editor = new Editor(this);
   connect(editor, &Editor::updateWindowTitle, this, &MainWindow::setWindowTitle);
   connect(editor, &Editor::documentModified, this, &MainWindow::setWindowModified);
@@ -59,6 +61,8 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent){
 }
 
 MainWindow::~MainWindow(){
+
+  Session::unregisterWindow(this);
   qDebug() << "Main window closed!";
 }
 
@@ -95,17 +99,39 @@ void MainWindow::setupWindow(){
   findAction->setStatusTip(tr("Find and replace"));
   connect(findAction, &QAction::triggered, this, &MainWindow::toggleFind);
 
+  documentsAction = new QAction(tr("Open &documents..."), this);
+  documentsAction->setStatusTip(tr("List open documents and their memory use"));
+  connect(documentsAction, &QAction::triggered, this, &MainWindow::showDocuments);
+
   exitAction = new QAction(tr("&Exit"), this);
   exitAction->setShortcut(tr("Ctrl+X"));
   exitAction->setStatusTip(tr("Close application"));
   connect(exitAction, &QAction::triggered, this, &MainWindow::close);
 
+  quitAction = new QAction(tr("&Quit"), this);
+  quitAction->setShortcut(QKeySequence::Quit);
+  quitAction->setStatusTip(tr("Close all windows and save the session"));
+  connect(quitAction, &QAction::triggered, this, &MainWindow::quit);
+
   lineWrapAction = new QAction(tr("Line wrap"), this);
   lineWrapAction->setCheckable(true);
   lineWrapAction->setChecked(true);
   lineWrapAction->setStatusTip(tr("Enable/disable line wrapping"));
   connect(lineWrapAction, &QAction::toggled, this, &MainWindow::toggleLineWrap);
 
+  memoryBudgetAction = new QAction(tr("Memory budget..."), this);
+  memoryBudgetAction->setStatusTip(tr("Set the memory idle documents are unloaded to stay within"));
+  connect(memoryBudgetAction, &QAction::triggered, this, &MainWindow::changeMemoryBudget);
+
+  restoreSessionAction = new QAction(tr("Restore session on startup"), this);
+  restoreSessionAction->setCheckable(true);
+  restoreSessionAction->setChecked(true);
+  restoreSessionAction->setStatusTip(tr("Reopen the windows of the last session on startup"));
+
+  largeFileThresholdAction = new QAction(tr("Large file threshold..."), this);
+  largeFileThresholdAction->setStatusTip(tr("Set the size at which files are opened read-only"));
+  connect(largeFileThresholdAction, &QAction::triggered, this, &MainWindow::changeLargeFileThreshold);
+
   const char *themeNames[] = {"default", "Purple Shades", "OLED"};
   for (int i = 0; i < 3; i++){
     QAction *action = new QAction(tr(themeNames[i]), this);
@@ -117,6 +143,21 @@ void MainWindow::setupWindow(){
     themeActions[i] = action;
   }
 
+  overlayAction = new QAction(tr("Performance overlay"), this);
+  overlayAction->setCheckable(true);
+  overlayAction->setStatusTip(tr("Show/hide frame time and keystroke latency"));
+  connect(overlayAction, &QAction::toggled, this, &MainWindow::togglePerformanceOverlay);
+
+  recordTraceAction = new QAction(tr("Record trace"), this);
+  recordTraceAction->setCheckable(true);
+  recordTraceAction->setChecked(Profiler::isEnabled());
+  recordTraceAction->setStatusTip(tr("Start/stop recording of performance trace events"));
+  connect(recordTraceAction, &QAction::toggled, this, &MainWindow::toggleTraceRecording);
+
+  exportTraceAction = new QAction(tr("Export trace..."), this);
+  exportTraceAction->setStatusTip(tr("Save recorded performance events as a Chrome trace file"));
+  connect(exportTraceAction, &QAction::triggered, this, &MainWindow::exportTrace);
+
   aboutAction = new QAction(tr("&About Editor"), this);
   aboutAction->setStatusTip(tr("About Editor"));
   connect(aboutAction, &QAction::triggered, editor, &Editor::about);
@@ -134,14 +175,28 @@ void MainWindow::setupWindow(){
   fileMenu->addAction(saveAsAction);
   fileMenu->addSeparator();
   fileMenu->addAction(findAction);
+  fileMenu->addAction(documentsAction);
   fileMenu->addSeparator();
   fileMenu->addAction(exitAction);
+  fileMenu->addAction(quitAction);
 
   QMenu *settingsMenu = menuBar()->addMenu(tr("&Settings"));
   settingsMenu->addAction(lineWrapAction);
+  settingsMenu->addAction(largeFileThresholdAction);
+  settingsMenu->addAction(memoryBudgetAction);
+  settingsMenu->addAction(restoreSessionAction);
   QMenu *themesMenu = settingsMenu->addMenu("Themes");
   for (int i = 0; i < 3; i++)
     themesMenu->addAction(themeActions[i]);
+  QMenu *performanceMenu = settingsMenu->addMenu(tr("Performance"));
+  performanceMenu->addAction(overlayAction);
+  performanceMenu->addAction(recordTraceAction);
+  performanceMenu->addAction(exportTraceAction);
+  connect(performanceMenu, &QMenu::aboutToShow, this, [this](){
+    // Recording is process-wide, and may have been toggled from another window.
+    QSignalBlocker blocker(recordTraceAction);
+    recordTraceAction->setChecked(Profiler::isEnabled());
+  });
 
   menuBar()->addSeparator();
   QMenu *aboutMenu = menuBar()->addMenu(tr("&About"));
@@ -167,6 +222,8 @@ void MainWindow::saveSettings(){
   qDebug() << "Saving application settings...";
   QSettings settings("Umar Abdul", "Editor");
   settings.setValue("line wrap", lineWrapAction->isChecked());
+  settings.setValue("performance overlay", overlayAction->isChecked());
+  settings.setValue("restore session", restoreSessionAction->isChecked());
   for (int i = 0; i < 3; i++){
     if (themeActions[i]->isChecked()){
       settings.setValue("theme", themeActions[i]->data().toString());
@@ -180,9 +237,57 @@ void MainWindow::loadSettings(){
   qDebug() << "Loading application settings...";
   QSettings settings("Umar Abdul", "Editor");
   lineWrapAction->setChecked(settings.value("line wrap", true).toBool());
+  overlayAction->setChecked(settings.value("performance overlay", false).toBool());
+  restoreSessionAction->setChecked(settings.value("restore session", true).toBool());
   setThemeByName(settings.value("theme", "default").toString());
 }
 
+void MainWindow::loadSharedSettings(){
+
+  QSettings settings("Umar Abdul", "Editor");
+  Editor::setLargeFileThreshold(settings.value("large file threshold", 64).toLongLong() * 1024 * 1024);
+  MemoryManager::instance()->setBudget(settings.value("memory budget", 512).toLongLong() * 1024 * 1024);
+}
+
+WindowState MainWindow::getSessionState(){
+
+  WindowState state;
+  state.filename = editor->getCurrentFile();
+  state.view = editor->getViewState();
+  state.findVisible = !findAndReplaceWidget->isHidden();
+  state.findText = findLineEdit->text();
+  state.replaceText = replaceLineEdit->text();
+  state.geometry = saveGeometry();
+  return state;
+}
+
+void MainWindow::restoreSessionState(const WindowState &state, bool loadNow){
+
+  restoreGeometry(state.geometry);
+  findLineEdit->setText(state.findText);
+  replaceLineEdit->setText(state.replaceText);
+  findAndReplaceWidget->setHidden(!state.findVisible);
+  editor->setPendingFile(state.filename, state.view);
+  if (loadNow)
+    editor->ensureLoaded();
+  else
+    editor->preload();
+}
+
+void MainWindow::quit(){
+
+  Session::save();
+  Session::setLocked(true); // Keep every window in the session while they close.
+  qApp->closeAllWindows();
+  Session::setLocked(false);
+  for (QWidget *widget : QApplication::topLevelWidgets()){
+    if (qobject_cast<MainWindow *>(widget) && widget->isVisible()){ // User cancelled closing a window. Save what's left open.
+      Session::save();
+      break;
+    }
+  }
+}
+
 void MainWindow::createNewDocument(){
   MainWindow *mw = new MainWindow();
   mw->show();
@@ -206,6 +311,7 @@ bool MainWindow::openFile(){
 
 bool MainWindow::setThemeByName(const QString &themeName){
 
+  PROFILE_SCOPE("MainWindow::setThemeByName");
   // Uncheck all other theme actions.
   for (int i = 0; i < 3; i++){
     QAction *action = themeActions[i];
@@ -272,10 +378,69 @@ void MainWindow::findAndReplace(){
   editor->findAndReplace(findLineEdit->text(), replaceLineEdit->text());
 }
 
+void MainWindow::changeLargeFileThreshold(){
+
+  bool ok = false;
+  int megabytes = QInputDialog::getInt(this, tr("Large file threshold"), tr("Open files of this size (MB) or larger read-only:"),
+                                       static_cast<int>(Editor::getLargeFileThreshold() / (1024 * 1024)), 1,
+                                       static_cast<int>(Editor::maxLargeFileThreshold / (1024 * 1024)), 1, &ok);
+  if (!ok)
+    return;
+  Editor::setLargeFileThreshold(static_cast<qint64>(megabytes) * 1024 * 1024);
+  QSettings settings("Umar Abdul", "Editor"); // Saved right away, as it's shared by all windows.
+  settings.setValue("large file threshold", megabytes);
+  showStatusMessage(tr("Large file threshold set to %1 MB!").arg(megabytes));
+}
+
+void MainWindow::changeMemoryBudget(){
+
+  bool ok = false;
+  int megabytes = QInputDialog::getInt(this, tr("Memory budget"), tr("Unload idle documents when all documents use more than (MB):"),
+                                       static_cast<int>(MemoryManager::instance()->getBudget() / (1024 * 1024)), 16, 1024 * 1024, 16, &ok);
+  if (!ok)
+    return;
+  MemoryManager::instance()->setBudget(static_cast<qint64>(megabytes) * 1024 * 1024);
+  QSettings settings("Umar Abdul", "Editor"); // Saved right away, as it's shared by all windows.
+  settings.setValue("memory budget", megabytes);
+  showStatusMessage(tr("Memory budget set to %1 MB!").arg(megabytes));
+}
+
+void MainWindow::showDocuments(){
+
+  DocumentsDialog *dialog = new DocumentsDialog(this);
+  dialog->setAttribute(Qt::WA_DeleteOnClose);
+  dialog->show();
+}
+
+void MainWindow::togglePerformanceOverlay(bool checked){
+  editor->setPerformanceOverlayVisible(checked);
+}
+
+void MainWindow::toggleTraceRecording(bool checked){
+
+  Profiler::setEnabled(checked);
+  showStatusMessage(checked ? tr("Recording performance trace...") : tr("Trace recording stopped!"));
+}
+
+bool MainWindow::exportTrace(){
+
+  QString filename = QFileDialog::getSaveFileName(this, tr("Export trace"), "editor-trace.json", tr("Chrome trace files (*.json)"));
+  if (filename.isEmpty())
+    return false;
+  QString error;
+  if (!Profiler::exportChromeTrace(filename, &error)){
+    QMessageBox::warning(this, "Editor", tr("Error exporting trace: %1\nReason: %2").arg(editor->getBaseFilename(filename)).arg(error));
+    return false;
+  }
+  showStatusMessage(tr("Trace exported: %1").arg(editor->getBaseFilename(filename)));
+  return true;
+}
+
 void MainWindow::closeEvent(QCloseEvent *event){
 
   if (editor->canCloseDocument()){
     saveSettings();
+    Session::save(this);
     qDebug() << "Closing main window...";
     event->accept();
   }else{
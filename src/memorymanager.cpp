@@ -0,0 +1,96 @@
+#include "memorymanager.h"
+#include "editor.h"
+#include "profiler.h"
+#include <QApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QDebug>
+#include <algorithm>
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+MemoryManager::MemoryManager(QObject *parent) : QObject(parent), budget(512 * 1024 * 1024){
+
+  timer = new QTimer(this);
+  timer->setInterval(checkInterval);
+  connect(timer, &QTimer::timeout, this, &MemoryManager::enforceBudget);
+  timer->start();
+}
+
+MemoryManager *MemoryManager::instance(){
+
+  static MemoryManager *manager = new MemoryManager(qApp); // Deleted with the application.
+  return manager;
+}
+
+void MemoryManager::registerEditor(Editor *editor){
+  editors.append(editor);
+}
+
+void MemoryManager::unregisterEditor(Editor *editor){
+  editors.removeAll(editor);
+}
+
+QList<Editor *> MemoryManager::getEditors(){
+  return editors;
+}
+
+qint64 MemoryManager::totalUsage(){
+
+  qint64 total = 0;
+  for (Editor *editor : editors)
+    total += editor->memoryUsage();
+  return total;
+}
+
+void MemoryManager::setBudget(qint64 bytes){
+  budget = bytes;
+}
+
+qint64 MemoryManager::getBudget(){
+  return budget;
+}
+
+qint64 MemoryManager::residentMemory(){
+
+#ifdef Q_OS_LINUX
+  QFile file("/proc/self/statm");
+  if (!file.open(QIODevice::ReadOnly))
+    return -1;
+  QList<QByteArray> fields = file.readAll().split(' ');
+  if (fields.size() < 2)
+    return -1;
+  return fields[1].toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+  return -1;
+#endif
+}
+
+int MemoryManager::enforceBudget(){
+
+  PROFILE_SCOPE("MemoryManager::enforceBudget");
+  qint64 total = totalUsage();
+  if (total <= budget)
+    return 0;
+  qint64 now = QDateTime::currentMSecsSinceEpoch();
+  QList<Editor *> candidates;
+  for (Editor *editor : editors){
+    // Includes windows not loaded yet that hold text read in the background.
+    if (editor->memoryUsage() > 0 && !editor->isActiveWindow() && now - editor->getLastActivity() >= minimumIdleTime)
+      candidates.append(editor);
+  }
+  std::sort(candidates.begin(), candidates.end(), [](Editor *a, Editor *b){ return a->getLastActivity() < b->getLastActivity(); });
+  int unloaded = 0;
+  for (Editor *editor : candidates){
+    if (total <= budget)
+      break;
+    qint64 usage = editor->memoryUsage();
+    if (editor->unloadDocument()){
+      total -= usage;
+      unloaded++;
+    }
+  }
+  qDebug() << "Unloaded" << unloaded << "idle documents to stay within the memory budget.";
+  return unloaded;
+}
@@ -0,0 +1,125 @@
+#include "profiler.h"
+#include <QFile>
+#include <QThread>
+#include <QCoreApplication>
+
+std::atomic<bool> Profiler::enabled(false);
+QMutex Profiler::mutex;
+QVector<Profiler::Event> Profiler::events;
+int Profiler::nextEvent = 0;
+QHash<QByteArray, qint64> Profiler::counters;
+
+static QElapsedTimer startedTimer(){
+
+  QElapsedTimer timer;
+  timer.start();
+  return timer;
+}
+
+QElapsedTimer &Profiler::clock(){
+
+  static QElapsedTimer timer = startedTimer(); // First use fixes the epoch all timestamps are relative to.
+  return timer;
+}
+
+void Profiler::setEnabled(bool on){
+
+  clock(); // Make sure the epoch is set before any probe reads it from another thread.
+  enabled.store(on, std::memory_order_relaxed);
+}
+
+qint64 Profiler::now(){
+  return clock().nsecsElapsed() / 1000;
+}
+
+void Profiler::record(const char *name, qint64 start, qint64 duration){
+
+  Event event = {name, start, duration, reinterpret_cast<quintptr>(QThread::currentThreadId())};
+  QMutexLocker locker(&mutex);
+  if (events.size() < maxEvents){
+    events.append(event);
+  }else{ // Buffer is full. Overwrite the oldest event.
+    events[nextEvent] = event;
+    nextEvent = (nextEvent + 1) % maxEvents;
+  }
+}
+
+void Profiler::count(const char *name, qint64 delta){
+
+  if (!isEnabled())
+    return;
+  QMutexLocker locker(&mutex);
+  counters[QByteArray::fromRawData(name, qstrlen(name))] += delta;
+}
+
+qint64 Profiler::counter(const char *name){
+
+  QMutexLocker locker(&mutex);
+  return counters.value(QByteArray::fromRawData(name, qstrlen(name)), 0);
+}
+
+void Profiler::clear(){
+
+  QMutexLocker locker(&mutex);
+  events.clear();
+  nextEvent = 0;
+  counters.clear();
+}
+
+int Profiler::eventCount(){
+
+  QMutexLocker locker(&mutex);
+  return events.size();
+}
+
+bool Profiler::exportChromeTrace(const QString &filename, QString *errorString){
+
+  // Take a snapshot so we don't hold the lock while writing to disk.
+  QVector<Event> snapshot;
+  QHash<QByteArray, qint64> counterSnapshot;
+  int first;
+  {
+    QMutexLocker locker(&mutex);
+    snapshot = events;
+    first = nextEvent;
+    for (QHash<QByteArray, qint64>::const_iterator it = counters.constBegin(); it != counters.constEnd(); ++it)
+      counterSnapshot.insert(QByteArray(it.key().constData(), it.key().size()), it.value()); // Deep copy the raw keys.
+  }
+
+  QFile file(filename);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)){
+    if (errorString)
+      *errorString = file.errorString();
+    return false;
+  }
+  qint64 pid = QCoreApplication::applicationPid();
+  QByteArray out;
+  out.reserve(snapshot.size() * 96 + 64);
+  out.append("{\"traceEvents\":[\n");
+  bool separator = false;
+  for (int i = 0; i < snapshot.size(); i++){
+    const Event &event = snapshot[(first + i) % snapshot.size()]; // Oldest first.
+    if (separator)
+      out.append(",\n");
+    separator = true;
+    out.append("{\"name\":\"").append(event.name).append("\",\"ph\":\"X\",\"ts\":").append(QByteArray::number(event.start))
+       .append(",\"dur\":").append(QByteArray::number(event.duration)).append(",\"pid\":").append(QByteArray::number(pid))
+       .append(",\"tid\":").append(QByteArray::number(static_cast<qulonglong>(event.thread))).append('}');
+  }
+  qint64 timestamp = now();
+  for (QHash<QByteArray, qint64>::const_iterator it = counterSnapshot.constBegin(); it != counterSnapshot.constEnd(); ++it){
+    if (separator)
+      out.append(",\n");
+    separator = true;
+    out.append("{\"name\":\"").append(it.key()).append("\",\"ph\":\"C\",\"ts\":").append(QByteArray::number(timestamp))
+       .append(",\"pid\":").append(QByteArray::number(pid)).append(",\"args\":{\"value\":").append(QByteArray::number(it.value())).append("}}");
+  }
+  out.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+  if (file.write(out) != out.size()){
+    if (errorString)
+      *errorString = file.errorString();
+    return false;
+  }
+  file.close();
+  return true;
+}
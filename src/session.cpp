@@ -0,0 +1,186 @@
+#include "session.h"
+#include "mainwindow.h"
+#include "profiler.h"
+#include <QStandardPaths>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QTimer>
+#include <QWindow>
+#include <QEvent>
+#include <functional>
+#include <QDebug>
+
+/**
+ * @brief Runs a callback once, right after a window is first exposed, and so painted. Deletes itself afterwards.
+ */
+class ExposeWatcher : public QObject{
+
+  public:
+
+    ExposeWatcher(std::function<void()> callback, QObject *parent) : QObject(parent), callback(callback), done(false){
+
+    }
+
+    bool eventFilter(QObject *watched, QEvent *event) override{
+
+      if (!done && event->type() == QEvent::Expose && static_cast<QWindow *>(watched)->isExposed()){
+        done = true;
+        QTimer::singleShot(0, callback); // Runs once the expose event has been handled, i.e: after the paint.
+        deleteLater();
+      }
+      return false;
+    }
+
+  private:
+
+    std::function<void()> callback;
+    bool done;
+};
+
+bool Session::locked = false;
+bool Session::restoring = false;
+QList<MainWindow *> Session::windows;
+
+QDataStream &operator<<(QDataStream &out, const WindowState &state){
+
+  out << state.filename << qint32(state.view.anchor) << qint32(state.view.position) << qint32(state.view.verticalScroll)
+      << qint32(state.view.horizontalScroll) << qint64(state.view.topLine) << state.findVisible << state.findText
+      << state.replaceText << state.geometry;
+  return out;
+}
+
+QDataStream &operator>>(QDataStream &in, WindowState &state){
+
+  qint32 anchor, position, verticalScroll, horizontalScroll;
+  qint64 topLine;
+  in >> state.filename >> anchor >> position >> verticalScroll >> horizontalScroll >> topLine >> state.findVisible
+     >> state.findText >> state.replaceText >> state.geometry;
+  state.view.anchor = anchor;
+  state.view.position = position;
+  state.view.verticalScroll = verticalScroll;
+  state.view.horizontalScroll = horizontalScroll;
+  state.view.topLine = topLine;
+  return in;
+}
+
+QString Session::sessionFile(){
+  return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/session.dat";
+}
+
+void Session::setLocked(bool locked){
+  Session::locked = locked;
+}
+
+void Session::registerWindow(MainWindow *window){
+  windows.append(window);
+}
+
+void Session::unregisterWindow(MainWindow *window){
+  windows.removeAll(window);
+}
+
+bool Session::save(MainWindow *closing){
+
+  if (locked || restoring)
+    return true;
+  PROFILE_SCOPE("Session::save");
+  QList<MainWindow *> visible;
+  for (MainWindow *window : windows){
+    if (window->isVisible())
+      visible.append(window);
+  }
+  QList<WindowState> states;
+  quint32 active = 0;
+  for (MainWindow *window : visible){
+    if (window == closing && visible.size() > 1)
+      continue;
+    WindowState state = window->getSessionState();
+    if (state.filename.isEmpty()) // Untitled documents can't be restored.
+      continue;
+    if (window->isActiveWindow())
+      active = states.size();
+    states.append(state);
+  }
+
+  qDebug() << "Saving session of" << states.size() << "windows...";
+  QDir().mkpath(QFileInfo(sessionFile()).absolutePath());
+  QSaveFile file(sessionFile());
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+  QDataStream out(&file);
+  out.setVersion(QDataStream::Qt_5_12);
+  out << magic << version << active << quint32(states.size());
+  for (const WindowState &state : states)
+    out << state;
+  return out.status() == QDataStream::Ok && file.commit(); // Replaces the old session only if everything was written.
+}
+
+MainWindow *Session::restore(){
+
+  QSettings settings("Umar Abdul", "Editor");
+  if (!settings.value("restore session", true).toBool())
+    return nullptr;
+  PROFILE_SCOPE("Session::restore");
+  QFile file(sessionFile());
+  if (!file.open(QIODevice::ReadOnly))
+    return nullptr;
+  QDataStream in(&file);
+  in.setVersion(QDataStream::Qt_5_12);
+  quint32 fileMagic, active, count;
+  quint16 fileVersion;
+  in >> fileMagic >> fileVersion >> active >> count;
+  if (in.status() != QDataStream::Ok || fileMagic != magic || fileVersion != version)
+    return nullptr;
+  QList<WindowState> states;
+  int activeIndex = 0;
+  for (quint32 i = 0; i < count; i++){
+    WindowState state;
+    in >> state;
+    if (in.status() != QDataStream::Ok)
+      break;
+    if (!QFileInfo::exists(state.filename)) // Deleted or moved since the last run.
+      continue;
+    if (i == active)
+      activeIndex = states.size();
+    states.append(state);
+  }
+  if (states.isEmpty())
+    return nullptr;
+
+  qDebug() << "Restoring session of" << states.size() << "windows...";
+  restoring = true; // A window closed now would overwrite the session before the others exist.
+  MainWindow *window = new MainWindow();
+  window->restoreSessionState(states.takeAt(activeIndex), true);
+  // Bring the other windows back once the first one is on screen, so creating them doesn't hold up its first paint.
+  QPointer<MainWindow> activeWindow(window);
+  window->winId(); // Creates the native window, so the watcher is in place before it's first exposed.
+  QWindow *handle = window->windowHandle();
+  handle->installEventFilter(new ExposeWatcher([states, activeWindow, activeIndex](){ restoreNext(states, activeWindow, activeIndex); },
+                                               handle));
+  window->show();
+  return window;
+}
+
+void Session::restoreNext(QList<WindowState> states, QPointer<MainWindow> activeWindow, int before){
+
+  if (states.isEmpty()){
+    restoring = false;
+    save(); // Drops any window the user closed while the others were being restored.
+    if (activeWindow){
+      activeWindow->raise();
+      activeWindow->activateWindow();
+    }
+    return;
+  }
+  MainWindow *window = new MainWindow();
+  if (before > 0 && activeWindow){ // Keep the saved order. The active window was created first.
+    windows.removeAll(window);
+    windows.insert(windows.indexOf(activeWindow.data()), window);
+  }
+  window->setAttribute(Qt::WA_ShowWithoutActivating); // Loading is deferred until the window is focused.
+  window->restoreSessionState(states.takeFirst(), false);
+  window->show();
+  QTimer::singleShot(0, [states, activeWindow, before](){ restoreNext(states, activeWindow, before - 1); });
+}